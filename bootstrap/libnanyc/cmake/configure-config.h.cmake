@@ -29,6 +29,24 @@ static constexpr bool removeRedundantDbgOffset = true;
 // (reference counter)
 static constexpr const uint32_t extraObjectSize = (uint32_t) sizeof(uint64_t);
 
+//! Maximum size (in opcodes) of a function to be inlined into its callers
+static constexpr uint32_t maxInlinedFuncSize = 24;
+
+//! Maximum size (in opcodes) of a function, beyond which no func call is inlined anymore
+static constexpr uint32_t maxInliningSequenceSize = 4096;
+
+//! Maximum number of registers of a function, beyond which no func call is inlined anymore
+static constexpr uint32_t maxInlinedFrameSize = 1024;
+
+//! VM: objects up to this size (in bytes) are allocated from per-thread pools
+static constexpr uint32_t vmPoolMaxObjectSize = 256;
+
+//! VM: size (in bytes) of each slab of the memory pools
+static constexpr uint32_t vmPoolSlabSize = 64 * 1024;
+
+//! VM: default maximum depth of nested func calls (see `nyvm_opts_t.max_call_depth`)
+static constexpr uint32_t vmMaxCallDepth = 256 * 1024;
+
 //! Import the NSL
 static constexpr bool importNSL = true;
 
@@ -42,6 +42,9 @@ static constexpr bool sourceOpcodeSequence = all or recommended or false;
 //! Print opcodes after program instanciation
 static constexpr bool generatedOpcodeSequence = all or recommended or false;
 
+//! Print each func call inlined
+static constexpr bool inlining = all or false;
+
 //! Additionnal traces for properties resolution
 static constexpr bool properties = all or false;
 
@@ -51,7 +54,7 @@ static constexpr bool raisedErrorSummary = all or false;
 static constexpr bool hasSome() {
 	return ast or astBeforeNormalize or astAfterNormalize or atomTable or preAtomTable
 		or allTypeDefinitions or classdefTable or sourceOpcodeSequence or generatedOpcodeSequence
-		or properties or raisedErrorSummary;
+		or inlining or properties or raisedErrorSummary;
 }
 
 } // ny::config::traces
@@ -52,13 +52,15 @@ auto findBuiltinAtom(Atom& root, CType kind, const AnyString& name) {
 
 AtomMap::AtomMap(StringRefs& stringrefs)
 	: root(AnyString(), Atom::Type::namespacedef) // global namespace
-	, stringrefs(stringrefs) {
+	, stringrefs(stringrefs)
+	, symbols(stringrefs) {
+	root.m_symbols = &symbols;
 	// since `m_atomGrpID` will start from 1
 	m_byIndex.emplace_back(nullptr);
 }
 
 Atom& AtomMap::createNewAtom(Atom::Type type, Atom& parent, const AnyString& name) {
-	auto newnode = yuni::make_ref<Atom>(parent, stringrefs.refstr(name), type);
+	auto newnode = yuni::make_ref<Atom>(parent, symbols.intern(name), type);
 	newnode->atomid = ++m_atomGrpID;
 	m_byIndex.emplace_back(newnode);
 	return *newnode;
@@ -54,6 +54,8 @@ public:
 	Atom root;
 	//! String catalog
 	StringRefs& stringrefs;
+	//! Interned names of all atoms (from the string catalog)
+	Symbols symbols;
 
 	struct {
 		yuni::Ref<Atom> object[ctypeCount];
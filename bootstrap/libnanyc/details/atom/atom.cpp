@@ -243,8 +243,10 @@ Atom::Atom(Atom& rootparent, const AnyString& name, Atom::Type type)
 	: category{findCategory(&rootparent, type, name)}
 	, type(type)
 	, parent(&rootparent)
-	, m_name{name} {
+	, m_name{name}
+	, m_symbols(rootparent.m_symbols) {
 	rootparent.m_children.emplace(AnyString{m_name}, this);
+	rootparent.indexChild(*this);
 }
 
 Atom::~Atom() {
@@ -359,19 +361,33 @@ void Atom::printTree(const ClassdefTableView& table) const {
 	printTreeRecursive(*this, table);
 }
 
+void Atom::indexChild(Atom& child) {
+	if (m_symbols == nullptr)
+		return;
+	child.m_symbol = m_symbols->find(child.m_name);
+	if (child.m_symbol != 0)
+		m_childIndex.insert(child.m_symbol, &child);
+	++m_symbols->generation; // the cached lookups may be incomplete
+}
+
 bool Atom::nameLookupOnChildren(std::vector<std::reference_wrapper<Atom>>& list, const AnyString& name,
 		bool* singleHop) {
 	assert(not name.empty());
+	uint32_t symbol = (m_symbols != nullptr) ? m_symbols->find(name) : 0;
+	return lookupOnChildren(list, symbol, (name == "^()"), singleHop);
+}
+
+bool Atom::lookupOnChildren(std::vector<std::reference_wrapper<Atom>>& list, uint32_t symbol, bool isFuncCall,
+		bool* singleHop) {
 	// the current scope
 	Atom& scope = *this;
 	// shorthand for func call ?
-	bool isFuncCall = (name == "^()");
 	if (isFuncCall and scope.isFunction()) { // shorthand for function calls
 		list.push_back(std::ref(scope));
 		return true;
 	}
 	bool success = false;
-	scope.eachChild(name, [&](Atom & child) -> bool {
+	scope.m_childIndex.each(symbol, [&](Atom & child) -> bool {
 		list.push_back(std::ref(child));
 		success = true;
 		return true; // let's continue
@@ -385,6 +401,40 @@ bool Atom::nameLookupOnChildren(std::vector<std::reference_wrapper<Atom>>& list,
 
 bool Atom::nameLookupFromParentScope(std::vector<std::reference_wrapper<Atom>>& list, const AnyString& name) {
 	assert(not name.empty());
+	bool isFuncCall = (name == "^()");
+	uint32_t symbol = (m_symbols != nullptr) ? m_symbols->find(name) : 0;
+	if (symbol == 0 and not isFuncCall)
+		return false; // no atom with this name
+	return lookupFromParentScope(list, symbol, isFuncCall);
+}
+
+bool Atom::lookupFromParentScope(std::vector<std::reference_wrapper<Atom>>& list, uint32_t symbol,
+		bool isFuncCall) {
+	if (m_symbols != nullptr) {
+		auto& cache = m_lookupCache;
+		if (cache.generation != m_symbols->generation) {
+			cache.results.clear();
+			cache.generation = m_symbols->generation;
+		}
+		auto it = cache.results.find(symbol);
+		if (it == cache.results.end()) {
+			std::vector<std::reference_wrapper<Atom>> matches;
+			lookupFromParentScopeUncached(matches, symbol, isFuncCall);
+			std::vector<Atom*> atoms;
+			atoms.reserve(matches.size());
+			for (auto& match: matches)
+				atoms.push_back(&match.get());
+			it = cache.results.emplace(symbol, std::move(atoms)).first;
+		}
+		for (auto* atom: it->second)
+			list.push_back(std::ref(*atom));
+		return not it->second.empty();
+	}
+	return lookupFromParentScopeUncached(list, symbol, isFuncCall);
+}
+
+bool Atom::lookupFromParentScopeUncached(std::vector<std::reference_wrapper<Atom>>& list, uint32_t symbol,
+		bool isFuncCall) {
 	// the current scope
 	Atom* scope = parentScope();
 	// rule: do not continue if there are some matches and if the scope is a class
@@ -402,29 +452,30 @@ bool Atom::nameLookupFromParentScope(std::vector<std::reference_wrapper<Atom>>&
 		bool askToParentFirst = not this->isClass();
 		if (askToParentFirst) {
 			return // from the parent
-				(scope->nameLookupFromParentScope(list, name))
+				(scope->lookupFromParentScope(list, symbol, isFuncCall))
 				// or locally
-				or this->nameLookupOnChildren(list, name);
+				or this->lookupOnChildren(list, symbol, isFuncCall, nullptr);
 		}
 		else {
 			// try to resolve locally
-			return this->nameLookupOnChildren(list, name)
-				   or scope->nameLookupFromParentScope(list, name);
+			return this->lookupOnChildren(list, symbol, isFuncCall, nullptr)
+				   or scope->lookupFromParentScope(list, symbol, isFuncCall);
 		}
 	}
 	else {
 		// try to resolve locally
-		return this->nameLookupOnChildren(list, name);
+		return this->lookupOnChildren(list, symbol, isFuncCall, nullptr);
 	}
 }
 
 bool Atom::propertyLookupOnChildren(std::vector<std::reference_wrapper<Atom>>& list,
 		const AnyString& prefix, const AnyString& name) {
 	assert(not name.empty());
-	ShortString128 propname{prefix};
-	propname << name;
+	if (m_symbols == nullptr)
+		return false;
+	uint32_t symbol = m_symbols->find(prefix, name); // without building '^propget^name'
 	bool success = false;
-	eachChild(propname, [&](Atom & child) -> bool {
+	m_childIndex.each(symbol, [&](Atom & child) -> bool {
 		list.push_back(std::ref(child));
 		success = true;
 		return true; // let's continue
@@ -601,9 +652,13 @@ void Atom::renameChild(const AnyString& from, const AnyString& to) {
 		child = it->second;
 		it = m_children.erase(it);
 	}
-	child->m_name = to;
+	if (unlikely(!child))
+		return;
+	m_childIndex.remove(child->m_symbol, child.get());
+	child->m_name = (m_symbols != nullptr) ? m_symbols->intern(to) : to;
 	child->category = findCategory(child->parent, child->type, to);
 	m_children.emplace(AnyString{child->m_name}, child);
+	indexChild(*child);
 }
 
 bool Atom::findParent(const Atom& atom) const {
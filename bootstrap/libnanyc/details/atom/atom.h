@@ -16,6 +16,7 @@
 #include "details/atom/classdef.h"
 #include "details/atom/visibility.h"
 #include "details/atom/ctype.h"
+#include "details/atom/symbols.h"
 
 namespace ny { struct AtomMap; }
 namespace ny { struct ClassdefTable; }
@@ -258,6 +259,7 @@ public:
 	/*!
 	** \brief Perform a name lookup from the local scope to the top root atom
 	**
+	** The results are cached for each scope, until an atom is added or renamed.
 	** \param[in,out] list List where all matches will be added
 	** \param name The identifier name to find
 	** \return True if at least one overload has been found
@@ -277,6 +279,7 @@ public:
 	/*!
 	** \brief Perform a name lookup on properties from the local scope only
 	**
+	** \param prefix The prefix of the property ('^propget^' or '^propset^')
 	** \param[in,out] list List where all matches will be added
 	** \param name The identifier name to find
 	** \return True if at least one overload has been found
@@ -534,11 +537,36 @@ public:
 	//! List of potential candidates for being captured
 	std::unique_ptr<std::unordered_set<AnyString>> candidatesForCapture;
 
+private:
+	//! Add a new child to the index
+	void indexChild(Atom& child);
+	//! Name lookup from the local scope to the top root atom (cached)
+	bool lookupFromParentScope(std::vector<std::reference_wrapper<Atom>>& list, uint32_t symbol, bool isFuncCall);
+	bool lookupFromParentScopeUncached(std::vector<std::reference_wrapper<Atom>>& list, uint32_t symbol,
+		bool isFuncCall);
+	//! Name lookup from the local scope only
+	bool lookupOnChildren(std::vector<std::reference_wrapper<Atom>>& list, uint32_t symbol, bool isFuncCall,
+		bool* singleHop);
+
 private:
 	//! Atoms that belong to this atom (sub-classes, methods...)
 	std::multimap<AnyString, yuni::Ref<Atom>> m_children;
+	//! Atoms that belong to this atom, indexed by their symbol
+	SymbolIndex m_childIndex;
 	//! Name of the current atom
 	AnyString m_name;
+	//! Interned names of all atoms (null if not attached to an atom map)
+	Symbols* m_symbols = nullptr;
+	//! Id of the name of the atom (0 if none)
+	uint32_t m_symbol = 0;
+	//! Results of the name lookups from this scope (see nameLookupFromParentScope())
+	struct {
+		//! Symbol -> all matches
+		std::unordered_map<uint32_t, std::vector<Atom*>> results;
+		//! Value of `Symbols::generation` when the cache was filled
+		uint32_t generation = 0;
+	}
+	m_lookupCache;
 	// nakama !
 	friend struct AtomMap;
 
@@ -182,7 +182,14 @@ inline void Atom::eachChild(const C& callback) const {
 }
 
 inline bool Atom::hasMember(const AnyString& name) const {
-	return (m_children.count(name) != 0);
+	if (unlikely(m_symbols == nullptr))
+		return (m_children.count(name) != 0);
+	bool found = false;
+	m_childIndex.each(m_symbols->find(name), [&](const Atom&) -> bool {
+		found = true;
+		return false;
+	});
+	return found;
 }
 
 template<class C>
@@ -0,0 +1,90 @@
+#include "symbols.h"
+
+using namespace Yuni;
+
+namespace ny {
+
+AnyString Symbols::intern(const AnyString& name) {
+	uint32_t id = m_names.ref(name);
+	// prefixed names, like '^propget^value'
+	if (name.size() > 2 and name[0] == '^') {
+		auto separator = name.find('^', 1);
+		if (separator < name.size() - 1) {
+			uint32_t prefix = m_names.ref(AnyString{name.c_str(), static_cast<uint32_t>(separator + 1)});
+			uint32_t suffix = m_names.ref(AnyString{name.c_str() + separator + 1,
+				static_cast<uint32_t>(name.size() - separator - 1)});
+			m_prefixed.emplace(key(prefix, suffix), id);
+		}
+	}
+	return m_names[id];
+}
+
+uint32_t Symbols::find(const AnyString& prefix, const AnyString& name) const {
+	assert(prefix.size() > 1 and prefix[0] == '^' and prefix[prefix.size() - 1] == '^');
+	uint32_t p = m_names.find(prefix);
+	uint32_t n = (p != 0) ? m_names.find(name) : 0;
+	if (n == 0)
+		return 0;
+	auto it = m_prefixed.find(key(p, n));
+	return (it != m_prefixed.end()) ? it->second : 0;
+}
+
+void SymbolIndex::insert(uint32_t symbol, Atom* atom) {
+	assert(symbol != 0 and atom != nullptr);
+	if ((m_size + 1) * 4 > static_cast<uint32_t>(m_entries.size()) * 3)
+		grow();
+	place(Entry{symbol, atom});
+	++m_size;
+}
+
+void SymbolIndex::place(const Entry& entry) {
+	uint32_t mask = static_cast<uint32_t>(m_entries.size()) - 1;
+	uint32_t i = hash(entry.symbol) & mask;
+	while (m_entries[i].symbol != 0)
+		i = (i + 1) & mask;
+	m_entries[i] = entry;
+}
+
+void SymbolIndex::grow() {
+	std::vector<Entry> old;
+	old.swap(m_entries);
+	uint32_t capacity = old.empty() ? 8u : static_cast<uint32_t>(old.size()) * 2;
+	m_entries.assign(capacity, Entry{0, nullptr});
+	if (old.empty())
+		return;
+	// starting from an empty slot, the children with the same symbol
+	// are found in the order of their insertion
+	uint32_t count = static_cast<uint32_t>(old.size());
+	uint32_t start = 0;
+	while (old[start].symbol != 0)
+		++start;
+	for (uint32_t i = 1; i <= count; ++i) {
+		auto& entry = old[(start + i) & (count - 1)];
+		if (entry.symbol != 0)
+			place(entry);
+	}
+}
+
+void SymbolIndex::remove(uint32_t symbol, Atom* atom) {
+	if (m_entries.empty())
+		return;
+	uint32_t mask = static_cast<uint32_t>(m_entries.size()) - 1;
+	uint32_t i = hash(symbol) & mask;
+	for ( ; ; i = (i + 1) & mask) {
+		auto& entry = m_entries[i];
+		if (entry.symbol == 0)
+			return; // not found
+		if (entry.symbol == symbol and entry.atom == atom)
+			break;
+	}
+	m_entries[i] = Entry{0, nullptr};
+	--m_size;
+	// the next entries of the chain may have to move back
+	for (i = (i + 1) & mask; m_entries[i].symbol != 0; i = (i + 1) & mask) {
+		Entry entry = m_entries[i];
+		m_entries[i] = Entry{0, nullptr};
+		place(entry);
+	}
+}
+
+} // namespace ny
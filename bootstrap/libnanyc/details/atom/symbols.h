@@ -0,0 +1,85 @@
+#pragma once
+#include "libnanyc.h"
+#include "details/utils/stringrefs.h"
+#include <unordered_map>
+#include <vector>
+
+namespace ny {
+
+struct Atom;
+
+/*!
+** \brief Interned names of all atoms
+**
+** Each name gets a unique id, its index within the string catalog of the atom
+** map, so that the name lookups compare integers instead of strings.
+** \note This class is not thread-safe
+*/
+struct Symbols final {
+	explicit Symbols(StringRefs& names): m_names(names) {}
+	Symbols(const Symbols&) = delete;
+	Symbols& operator = (const Symbols&) = delete;
+
+	//! Intern a new name (the returned string remains valid as long as the catalog)
+	AnyString intern(const AnyString& name);
+	//! Get the id of a name (0 if no atom has this name)
+	uint32_t find(const AnyString& name) const;
+	/*!
+	** \brief Get the id of a prefixed name (ex: "^propget^" + "value"), without concatenation
+	**
+	** \param prefix A prefix, like '^propget^' (must start and end with '^')
+	** \return The id of the name, 0 if no atom has this name
+	*/
+	uint32_t find(const AnyString& prefix, const AnyString& name) const;
+
+public:
+	//! Incremented each time the children of an atom are modified (see Atom::nameLookupFromParentScope())
+	uint32_t generation = 0;
+
+private:
+	static uint64_t key(uint32_t prefix, uint32_t name);
+
+private:
+	//! The string catalog of the atom map
+	StringRefs& m_names;
+	//! {prefix id, name id} -> prefixed name id, for all names like '^propget^value'
+	std::unordered_map<uint64_t, uint32_t> m_prefixed;
+
+}; // struct Symbols
+
+/*!
+** \brief Children of an atom indexed by their symbol (flat hash table, linear probing)
+**
+** Several children may share the same name (overloads). They are visited
+** in the order of their insertion, like with a std::multimap.
+*/
+struct SymbolIndex final {
+	//! Add a new child
+	void insert(uint32_t symbol, Atom* atom);
+	//! Remove a child
+	void remove(uint32_t symbol, Atom* atom);
+	//! Visit all children with a given symbol, until the callback returns false
+	template<class C> void each(uint32_t symbol, const C& callback) const;
+	//! Number of children
+	uint32_t size() const;
+
+private:
+	struct Entry final {
+		uint32_t symbol; // 0 if the slot is empty
+		Atom* atom;
+	};
+	static uint32_t hash(uint32_t symbol);
+	void place(const Entry&);
+	void grow();
+
+private:
+	//! All slots (power of 2)
+	std::vector<Entry> m_entries;
+	//! Number of used slots
+	uint32_t m_size = 0;
+
+}; // struct SymbolIndex
+
+} // namespace ny
+
+#include "symbols.hxx"
@@ -0,0 +1,36 @@
+#pragma once
+#include "symbols.h"
+
+namespace ny {
+
+inline uint32_t Symbols::find(const AnyString& name) const {
+	return m_names.find(name);
+}
+
+inline uint64_t Symbols::key(uint32_t prefix, uint32_t name) {
+	return (static_cast<uint64_t>(prefix) << 32) | name;
+}
+
+inline uint32_t SymbolIndex::hash(uint32_t symbol) {
+	return symbol * 2654435761u; // Knuth
+}
+
+inline uint32_t SymbolIndex::size() const {
+	return m_size;
+}
+
+template<class C>
+inline void SymbolIndex::each(uint32_t symbol, const C& callback) const {
+	if (m_entries.empty() or symbol == 0)
+		return;
+	uint32_t mask = static_cast<uint32_t>(m_entries.size()) - 1;
+	for (uint32_t i = hash(symbol) & mask; ; i = (i + 1) & mask) {
+		auto& entry = m_entries[i];
+		if (entry.symbol == 0) // end of the chain, never full
+			return;
+		if (entry.symbol == symbol and not callback(*entry.atom))
+			return;
+	}
+}
+
+} // namespace ny
@@ -0,0 +1,208 @@
+#include "details/compiler/cache.h"
+#include "libnanyc-version.h"
+#include "details/ir/isa/data.h"
+#include <yuni/io/file.h>
+#include <yuni/io/directory.h>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#ifndef LIBNANYC_FRONTEND_FINGERPRINT
+// hash of the sources of the front-end (grammar, ast, ir...), provided by cmake
+#define LIBNANYC_FRONTEND_FINGERPRINT ""
+#endif
+
+namespace ny::compiler {
+
+namespace {
+
+//! Version of the file format, to increment for any change in the layout or in the IR produced
+//! (2: debugpos for the nodes of the first line)
+constexpr uint32_t formatVersion = 2;
+
+constexpr char magic[8] = {'n', 'y', 'i', 'r', 'c', 'c', 'h', '\0'};
+
+struct Header final {
+	char magic[8];
+	uint32_t format;
+	//! Number of opcodes in the instruction set, to discard files from another ISA
+	uint32_t opcodeCount;
+	uint64_t key;
+	uint32_t instructionCount;
+	uint32_t stringCount;
+	uint32_t usesCount;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(Header) % alignof(ir::Instruction) == 0, "instructions must be aligned after the header");
+
+constexpr uint32_t isaOpcodeCount = 1 + static_cast<uint32_t>(ir::isa::Op::end);
+
+//! FNV-1a
+uint64_t hash(uint64_t h, const AnyString& text) {
+	for (uint32_t i = 0; i != text.size(); ++i) {
+		h ^= static_cast<unsigned char>(text[i]);
+		h *= 0x100000001b3ull;
+	}
+	return h;
+}
+
+uint64_t hash(uint64_t h, uint32_t value) {
+	return hash(h, AnyString{reinterpret_cast<const char*>(&value), static_cast<uint32_t>(sizeof(value))});
+}
+
+/*!
+** \brief Fingerprint of everything the IR depends on, besides the source itself
+**
+** Any change in the front-end or in the instruction set (development builds
+** share the same version) produces another key, and the stale files are
+** simply ignored.
+*/
+uint64_t fingerprint() {
+	static const uint64_t value = []() -> uint64_t {
+		uint64_t h = 0xcbf29ce484222325ull;
+		h = hash(h, LIBNANYC_VERSION_STR);
+		h = hash(h, LIBNANYC_FRONTEND_FINGERPRINT);
+		h = hash(h, formatVersion);
+		#define LIBNANYC_IR_CACHE_OPERAND(OPCODE) \
+			h = hash(h, #OPCODE); \
+			h = hash(h, static_cast<uint32_t>(sizeof(ir::isa::Operand<ir::isa::Op::OPCODE>)));
+		LIBNANYC_IR_EACH_OPCODE(LIBNANYC_IR_CACHE_OPERAND)
+		#undef LIBNANYC_IR_CACHE_OPERAND
+		return h;
+	}();
+	return value;
+}
+
+void writeString(yuni::String& out, const AnyString& text) {
+	uint32_t len = text.size();
+	out.append(reinterpret_cast<const char*>(&len), static_cast<uint32_t>(sizeof(len)));
+	out.append(text.c_str(), len);
+}
+
+struct Reader final {
+	bool read(void* out, uint32_t size) {
+		if (unlikely(size > content.size() - offset))
+			return false;
+		memcpy(out, content.c_str() + offset, size);
+		offset += size;
+		return true;
+	}
+
+	bool readString(AnyString& text) {
+		uint32_t len;
+		if (unlikely(not read(&len, static_cast<uint32_t>(sizeof(len))) or len > content.size() - offset))
+			return false;
+		text.adapt(content.c_str() + offset, len);
+		offset += len;
+		return true;
+	}
+
+	const yuni::String& content;
+	uint32_t offset = 0;
+};
+
+} // namespace
+
+IRCache::IRCache(const nycompile_opts_t& opts) {
+	if (opts.cache_path.len != 0)
+		path.assign(opts.cache_path.c_str, static_cast<uint32_t>(opts.cache_path.len));
+}
+
+uint64_t IRCache::key(const ny::compiler::Source& source) const {
+	uint64_t h = hash(fingerprint(), source.filename);
+	return hash(h, source.content);
+}
+
+void IRCache::cacheFilename(yuni::String& out, uint64_t key) const {
+	out.clear();
+	out << path << '/' << key << ".nyir";
+}
+
+bool IRCache::load(ny::compiler::Source& source) {
+	assert(enabled());
+	if (source.content.empty()) {
+		// the content is required for computing the key - will be reused by the parser
+		if (yuni::IO::errNone != yuni::IO::File::LoadFromFile(source.storageContent, source.filename))
+			return false;
+		source.content = source.storageContent;
+	}
+	uint64_t expectedKey = key(source);
+	yuni::String filename;
+	cacheFilename(filename, expectedKey);
+	yuni::String data;
+	if (yuni::IO::errNone != yuni::IO::File::LoadFromFile(data, filename))
+		return false;
+	Reader reader{data};
+	Header header;
+	bool valid = reader.read(&header, static_cast<uint32_t>(sizeof(header)))
+		and 0 == memcmp(header.magic, magic, sizeof(magic))
+		and header.format == formatVersion
+		and header.opcodeCount == isaOpcodeCount
+		and header.key == expectedKey
+		and header.instructionCount != 0
+		and header.instructionCount <= (data.size() - reader.offset) / sizeof(ir::Instruction);
+	if (unlikely(not valid))
+		return false;
+	auto& sequence = source.parsing.ircode;
+	auto& uses = source.parsing.uses;
+	sequence.clear();
+	sequence.append(reinterpret_cast<const ir::Instruction*>(data.c_str() + reader.offset), header.instructionCount);
+	reader.offset += header.instructionCount * static_cast<uint32_t>(sizeof(ir::Instruction));
+	AnyString text;
+	for (uint32_t i = 0; i != header.stringCount; ++i) {
+		// the index of each string must be preserved (element 0 is always the empty string)
+		if (unlikely(not reader.readString(text) or sequence.stringrefs.ref(text) != i + 1)) {
+			sequence.clear();
+			return false;
+		}
+	}
+	uses.clear();
+	for (uint32_t i = 0; i != header.usesCount; ++i) {
+		if (unlikely(not reader.readString(text))) {
+			sequence.clear();
+			uses.clear();
+			return false;
+		}
+		uses.emplace_back(text);
+	}
+	return true;
+}
+
+void IRCache::store(const ny::compiler::Source& source) {
+	assert(enabled());
+	auto& sequence = source.parsing.ircode;
+	auto& uses = source.parsing.uses;
+	if (unlikely(sequence.opcodeCount() == 0))
+		return;
+	Header header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.format = formatVersion;
+	header.opcodeCount = isaOpcodeCount;
+	header.key = key(source);
+	header.instructionCount = sequence.opcodeCount();
+	header.stringCount = sequence.stringrefs.size() - 1;
+	header.usesCount = static_cast<uint32_t>(uses.size());
+	header.reserved = 0;
+	yuni::String data;
+	data.reserve(static_cast<uint32_t>(sizeof(header) + header.instructionCount * sizeof(ir::Instruction)));
+	data.append(reinterpret_cast<const char*>(&header), static_cast<uint32_t>(sizeof(header)));
+	data.append(reinterpret_cast<const char*>(&sequence.at(0)), header.instructionCount * static_cast<uint32_t>(sizeof(ir::Instruction)));
+	for (uint32_t i = 1; i <= header.stringCount; ++i)
+		writeString(data, sequence.stringrefs[i]);
+	for (auto& name: uses)
+		writeString(data, name);
+	if (not yuni::IO::Directory::Exists(path) and not yuni::IO::Directory::Create(path))
+		return;
+	yuni::String filename;
+	cacheFilename(filename, header.key);
+	// several compilers may share the same cache directory (unittests for ex.)
+	yuni::String tmpfilename;
+	tmpfilename << filename << ".tmp" << std::random_device{}();
+	if (yuni::IO::File::SetContent(tmpfilename, data)) {
+		if (0 != std::rename(tmpfilename.c_str(), filename.c_str()))
+			std::remove(tmpfilename.c_str());
+	}
+}
+
+} // ny::compiler
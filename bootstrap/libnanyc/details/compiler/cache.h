@@ -0,0 +1,43 @@
+#pragma once
+#include "details/compiler/compdb.h"
+#include <yuni/string.h>
+
+namespace ny::compiler {
+
+/*!
+** \brief Persistent cache of the IR generated from a source file
+**
+** The sequence produced by the front-end (parsing, AST normalization and IR
+** generation) only depends on the content of the source, its filename and
+** the compiler itself (version, front-end and instruction set). It is stored as a flat binary file (header,
+** instructions, strings, collections used), keyed by a hash of those inputs,
+** to skip the front-end entirely for files which rarely change (the NSL and
+** the collections). The mapping (attach) is always performed. Sources which
+** produced any diagnostic (ex: warnings) are not stored.
+*/
+struct IRCache final {
+	explicit IRCache(const nycompile_opts_t&);
+
+	//! Get if the cache is enabled
+	bool enabled() const { return not path.empty(); }
+
+	/*!
+	** \brief Try to load the IR of a source from the cache
+	**
+	** The content of the source is loaded from the filesystem if not already available.
+	** \return True if the IR sequence and the collections used have been loaded
+	*/
+	bool load(ny::compiler::Source&);
+
+	//! Store the IR of a source (must be called before any mapping)
+	void store(const ny::compiler::Source&);
+
+private:
+	uint64_t key(const ny::compiler::Source&) const;
+	void cacheFilename(yuni::String& out, uint64_t key) const;
+
+	//! Cache directory, empty if disabled
+	yuni::String path;
+};
+
+} // ny::compiler
@@ -3,9 +3,14 @@
 #include "details/reporting/message.h"
 #include "details/grammar/nany.h"
 #include "details/ir/sequence.h"
+#include "details/ir/bytecode.h"
 #include "details/atom/classdef-table.h"
 #include "details/intrinsic/catalog.h"
+#include "details/semantic/overload-cache.h"
+#include "details/compiler/profiler.h"
 #include <deque>
+#include <unordered_map>
+#include <vector>
 #include <memory>
 #include <cassert>
 
@@ -25,6 +30,8 @@ struct Source final {
 		yuni::Ref<AST::Node> rootnode;
 		//! The original sequence, generated from the normalized AST
 		ir::Sequence ircode;
+		//! All collections used by the source (`uses`)
+		std::vector<yuni::String> uses;
 	}
 	parsing;
 
@@ -36,8 +43,24 @@ struct Source final {
 	ir::Sequence& sequence() { return parsing.ircode; }
 };
 
+//! Instanciated function, resolved once for all by the link step (see `link()`)
+struct Function final {
+	//! The IR code of the function
+	const ir::Sequence* ircode = nullptr;
+	//! The code executed by the VM
+	const ir::Bytecode* bytecode = nullptr;
+	//! Number of registers required by the function (stacksize)
+	uint32_t framesize = 0;
+	uint32_t atomid = 0;
+	uint32_t instanceid = 0;
+	//! Size of the object to release (dtor only, with the extra size for the refcount)
+	uint64_t objectsize = 0;
+	//! The function does nothing (dtor only: the object can be released without calling it)
+	bool trivial = false;
+};
+
 struct Compdb final {
-	Compdb(const nycompile_opts_t& opts): opts(opts) {}
+	Compdb(const nycompile_opts_t& opts): opts(opts), profiler(opts) {}
 	Compdb(const Compdb&) = delete;
 	Compdb(Compdb&&) = delete;
 	Compdb& operator = (const Compdb&) = delete;
@@ -45,7 +68,11 @@ struct Compdb final {
 
 	ClassdefTable cdeftable;
 	intrinsic::Catalog intrinsics;
+	//! Overload resolutions already performed (see OverloadedFuncCallResolver)
+	semantic::OverloadCache overloads;
 	const nycompile_opts_t& opts;
+	//! Measures of the compilation phases (see `nycompile_opts_t.on_profile`)
+	Profiler profiler;
 	Logs::Message messages{Logs::Level::none};
 	std::deque<Source> sources;
 	struct Entrypoint final {
@@ -53,6 +80,19 @@ struct Compdb final {
 		uint32_t instanceid = (uint32_t) -1;
 	}
 	entrypoint;
+	//! All instanciated entrypoints, by name (read-only once compiled)
+	std::unordered_map<yuni::String, Entrypoint> entrypoints;
+	//! All instanciated functions, for direct calls (read-only once compiled)
+	std::vector<Function> functions;
+	//! {atomid, instanceid} -> index in functions
+	std::unordered_map<uint64_t, uint32_t> functionIDs;
+	//! The bytecode of all functions (same order than functions)
+	std::deque<ir::Bytecode> bytecodes;
+	//! Find a linked function (null if not found)
+	const Function* findFunction(uint32_t atomid, uint32_t instanceid) const {
+		auto it = functionIDs.find((static_cast<uint64_t>(atomid) << 32) | instanceid);
+		return (it != functionIDs.end()) ? &functions[it->second] : nullptr;
+	}
 	yuni::Mutex mutex;
 };
 
@@ -1,5 +1,6 @@
 #include "details/compiler/compiler.h"
 #include "details/compiler/compdb.h"
+#include "details/compiler/cache.h"
 #include "details/program/program.h"
 #include "details/reporting/report.h"
 #include "details/errors/errors.h"
@@ -7,6 +8,7 @@
 #include "details/pass/b-ast-normalize/normalize.h"
 #include "details/pass/c-ast2ir/source-ast-to-ir.h"
 #include "details/pass/d-object-map/attach.h"
+#include "details/pass/f-link/link.h"
 #include "details/semantic/atom-factory.h"
 #include "details/intrinsic/std.core.h"
 #include "details/compiler/report.h"
@@ -15,7 +17,11 @@
 #include "libnanyc-version.h"
 #include "embed-nsl.hxx" // generated
 #include <yuni/io/file.h>
+#include <yuni/core/system/cpu.h>
+#include <yuni/job/queue/service.h>
+#include <yuni/thread/utility.h>
 #include <libnanyc.h>
+#include <algorithm>
 #include <utility>
 #include <memory>
 #include <unordered_map>
@@ -78,29 +84,59 @@ bool instanciate(ny::compiler::Compdb& compdb, ny::Logs::Report& report, AnyStri
 		report.appendEntry(settings.report);
 		if (config::traces::atomTable)
 			compdb.cdeftable.atoms.root.printTree(compdb.cdeftable);
-		if (likely(instanciated)) {
-			compdb.entrypoint.atomid = atom.atomid;
-			compdb.entrypoint.instanceid = settings.instanceid;
-			return not report.hasErrors();
+		if (likely(instanciated and not report.hasErrors())) {
+			auto& ep = compdb.entrypoints[entrypoint];
+			ep.atomid = atom.atomid;
+			ep.instanceid = settings.instanceid;
+			return true;
 		}
 	}
 	catch (const char* e) {
 		report.error() << "failed to instanciate '" << entrypoint << e;
 	}
-	compdb.entrypoint.atomid = (uint32_t) -1;
-	compdb.entrypoint.instanceid = (uint32_t) -1;
 	return false;
 }
 
+bool instanciateAllEntrypoints(ny::compiler::Compdb& compdb, ny::Logs::Report& report) {
+	bool success = true;
+	auto& entrypoint = compdb.opts.entrypoint;
+	AnyString name{entrypoint.c_str, static_cast<uint32_t>(entrypoint.len)};
+	if (not name.empty()) {
+		success = instanciate(compdb, report, name);
+		if (success)
+			compdb.entrypoint = compdb.entrypoints[name];
+	}
+	auto& others = compdb.opts.entrypoints;
+	for (uint32_t i = 0; i != others.count; ++i) {
+		AnyString other{others.items[i].c_str, static_cast<uint32_t>(others.items[i].len)};
+		if (compdb.entrypoints.count(other) == 0)
+			success &= instanciate(compdb, report, other);
+	}
+	return success;
+}
+
+uint32_t numberOfJobs(const nycompile_opts_t& opts) {
+	// the callback for unittests is not required to be thread-safe
+	if (opts.on_unittest != nullptr)
+		return 1;
+	uint32_t jobs = (opts.jobs != 0) ? opts.jobs : static_cast<uint32_t>(yuni::System::CPU::Count());
+	return std::min(std::max(jobs, 1u), 64u); // arbitrary
+}
+
 struct CompilerQueue final {
 	ny::compiler::Compdb& compdb;
 	ny::Logs::Report report;
 	std::vector<yuni::String> collectionSearchPaths;
 	std::unordered_set<yuni::String> collectionsLoaded;
+	IRCache cache;
+	//! Number of threads for the front-end
+	uint32_t jobs;
 
 	CompilerQueue(ny::compiler::Compdb& compdb)
 		: compdb(compdb)
-		, report(compdb.messages) {
+		, report(compdb.messages)
+		, cache(compdb.opts)
+		, jobs(numberOfJobs(compdb.opts)) {
 		collectionSearchPaths.reserve(4);
 		collectionSearchPaths.emplace_back(ny::config::collectionSystemPath);
 	}
@@ -143,23 +179,105 @@ struct CompilerQueue final {
 			err.hint() << "from path '" << searchpath << "'";
 	}
 
-	bool compileSource(ny::compiler::Source& source) {
+	static void usesCollectionFromSource(void* userdata, const AnyString& name) {
+		auto& source = *(reinterpret_cast<ny::compiler::Source*>(userdata));
+		source.parsing.uses.emplace_back(name);
+	}
+
+	//! Parse, normalize and generate the IR of a source (thread-safe)
+	bool frontend(ny::compiler::Source& source) {
+		// the unittest events are only emitted by the front-end
+		bool withCache = cache.enabled() and compdb.opts.on_unittest == nullptr;
+		auto& profiler = compdb.profiler;
+		auto mark = profiler.start();
+		if (withCache and cache.load(source)) {
+			profiler.add(nycompile_phase_cache, mark, source.filename);
+			if (unlikely(compdb.opts.verbose == nytrue))
+				info() << "compile " << source.filename << " (cached)";
+			return true;
+		}
 		if (unlikely(compdb.opts.verbose == nytrue))
 			info() << "compile " << source.filename;
 		auto subreport = report.subgroup();
 		subreport.data().origins.location.filename = source.filename;
 		subreport.data().origins.location.target.clear();
+		source.parsing.uses.clear();
 		bool compiled = true;
+		mark = profiler.start(); // the lookup in the cache is not part of the parsing
 		compiled &= makeASTFromSource(source);
-		compiled &= passDuplicateAndNormalizeAST(source, subreport, &usesCollection, this);
+		mark = profiler.add(nycompile_phase_parse, mark, source.filename);
+		compiled &= passDuplicateAndNormalizeAST(source, subreport, &usesCollectionFromSource, &source);
+		mark = profiler.add(nycompile_phase_normalize, mark, source.filename);
 		compiled &= passTransformASTToIR(source, subreport, compdb.opts);
-		compiled  = compiled and attach(compdb, source);
+		profiler.add(nycompile_phase_ast2ir, mark, source.filename);
+		// the diagnostics are not cached, the source would be silently accepted next time
+		if (withCache and compiled and subreport.data().entries.empty())
+			cache.store(source);
 		return compiled;
 	}
 
-	bool importSourceAndCompile(ny::compiler::Source& source, const nysource_opts_t& opts) {
-		copySourceOpts(source, opts);
-		return compileSource(source);
+	//! Run the front-end for all sources in [first, last), on several threads if possible
+	void frontends(uint32_t first, uint32_t last, std::vector<uint8_t>& results) {
+		results.assign(last - first, 0);
+		auto run = [&](uint32_t i) {
+			try {
+				results[i - first] = frontend(compdb.sources[i]) ? 1 : 0;
+			}
+			catch (const std::bad_alloc&) {
+				report.ice() << "not enough memory when compiling " << compdb.sources[i].filename;
+			}
+			catch (...) {
+				report.ice() << "uncaught exception when compiling " << compdb.sources[i].filename;
+			}
+		};
+		uint32_t count = std::min(jobs, last - first);
+		if (count <= 1) {
+			for (uint32_t i = first; i != last; ++i)
+				run(i);
+			return;
+		}
+		yuni::Job::QueueService queueservice;
+		queueservice.maximumThreadCount(count);
+		queueservice.minimumThreadCount(count);
+		for (uint32_t i = first; i != last; ++i) {
+			yuni::async(queueservice, [&, i] {
+				Logs::Handler errorHandler{&report, &buildGenerateReport};
+				run(i);
+			});
+		}
+		queueservice.start();
+		queueservice.wait(yuni::qseIdle);
+	}
+
+	/*!
+	** \brief Compile all sources from a given index, and the collections they use
+	**
+	** The front-end is run in parallel, then the sources are mapped one after
+	** another, in order, to keep the atom ids deterministic. New collections are
+	** processed the same way, until no source is added.
+	*/
+	bool compileSources(uint32_t first) {
+		auto& sources = compdb.sources;
+		std::vector<uint8_t> results;
+		bool compiled = true;
+		while (first < sources.size()) {
+			uint32_t last = static_cast<uint32_t>(sources.size());
+			frontends(first, last, results);
+			for (uint32_t i = first; i != last; ++i) {
+				auto& source = sources[i];
+				for (auto& name: source.parsing.uses)
+					usesCollection(this, name);
+				if (results[i - first] != 0) {
+					auto mark = compdb.profiler.start();
+					compiled &= attach(compdb, source);
+					compdb.profiler.add(nycompile_phase_attach, mark, source.filename);
+				}
+				else
+					compiled = false;
+			}
+			first = last;
+		}
+		return compiled;
 	}
 };
 
@@ -167,6 +285,7 @@ std::unique_ptr<ny::Program> compile(ny::compiler::Compdb& compdb) {
 	CompilerQueue queue(compdb);
 	auto& report = queue.report;
 	Logs::Handler errorHandler{&report, &buildGenerateReport};
+	auto& profiler = compdb.profiler;
 	try {
 		if (unlikely(compdb.opts.verbose == nytrue))
 			bugReportInfo(report);
@@ -175,45 +294,48 @@ std::unique_ptr<ny::Program> compile(ny::compiler::Compdb& compdb) {
 			throw "no input source code";
 		if (config::importNSL)
 			ny::intrinsic::import::all(compdb.intrinsics);
+		for (uint32_t i = 0; i != compdb.opts.intrinsics.count; ++i) {
+			auto& host = compdb.opts.intrinsics.items[i];
+			if (unlikely(not compdb.intrinsics.emplace(host))) {
+				report.error() << "invalid or duplicate host intrinsic '"
+					<< AnyString{host.name.c_str, static_cast<uint32_t>(host.name.len)} << '\'';
+				return nullptr;
+			}
+		}
 		if (config::importNSL)
 			scount += corefilesCount;
 		auto& sources = compdb.sources;
 		sources.resize(scount);
-		bool compiled = true;
 		uint32_t offset = 0;
-		if (config::importNSL) {
-			registerNSLCoreFiles(sources, offset, [&](ny::compiler::Source& source) {
-				compiled &= queue.compileSource(source);
-			});
-		}
+		if (config::importNSL)
+			registerNSLCoreFiles(sources, offset, [](ny::compiler::Source&) {});
 		if (unlikely(compdb.opts.with_nsl_unittests == nytrue))
 			queue.usesCollection(&queue, "nsl.selftest");
-		for (uint32_t i = 0; i != compdb.opts.sources.count; ++i) {
-			auto& source = sources[offset + i];
-			compiled &= queue.importSourceAndCompile(source, compdb.opts.sources.items[i]);
-		}
-		for (uint32_t i = offset + compdb.opts.sources.count; i < sources.size(); ++i) {
-			auto& source = sources[i];
-			compiled &= queue.compileSource(source);
-		}
+		for (uint32_t i = 0; i != compdb.opts.sources.count; ++i)
+			copySourceOpts(sources[offset + i], compdb.opts.sources.items[i]);
+		bool compiled = queue.compileSources(0);
 		if (unlikely(compdb.opts.verbose == nytrue))
 			report.info() << "building... ";
+		auto mark = profiler.start();
 		compiled = compiled
 			and likely(compdb.opts.on_unittest == nullptr)
 			and compdb.cdeftable.atoms.fetchAndIndexCoreObjects() // indexing bool, u32, f64...
 			and ny::semantic::resolveStrictParameterTypes(compdb, compdb.cdeftable.atoms.root); // typedef
+		profiler.add(nycompile_phase_typedefs, mark);
 		if (config::traces::preAtomTable)
 			compdb.cdeftable.atoms.root.printTree(ClassdefTableView{compdb.cdeftable});
 		if (unlikely(not compiled))
 			return nullptr;
-		auto& entrypoint = compdb.opts.entrypoint;
-		if (unlikely(entrypoint.len == 0))
+		if (unlikely(compdb.opts.entrypoint.len == 0 and compdb.opts.entrypoints.count == 0))
 			return nullptr;
-		bool epinst = instanciate(compdb, report, AnyString(entrypoint.c_str, static_cast<uint32_t>(entrypoint.len)));
+		bool epinst = instanciateAllEntrypoints(compdb, report);
 		if (config::traces::raisedErrorSummary)
 			ny::compiler::report::raisedErrorsForAllAtoms(compdb, report);
 		if (unlikely(not epinst))
 			return nullptr;
+		mark = profiler.start();
+		ny::compiler::link(compdb);
+		profiler.add(nycompile_phase_link, mark);
 		return std::make_unique<ny::Program>();
 	}
 	catch (const std::bad_alloc&) {
@@ -246,7 +368,12 @@ nyprogram_t* compile(nycompile_opts_t& opts) {
 		if (opts.on_build_start)
 			opts.userdata = opts.on_build_start(opts.userdata);
 		auto compdb = std::make_unique<Compdb>(opts);
+		auto mark = compdb->profiler.start();
 		auto program = compile(*compdb);
+		if (unlikely(compdb->profiler.enabled())) {
+			compdb->profiler.add(nycompile_phase_total, mark);
+			compdb->profiler.report(compdb->cdeftable.atoms);
+		}
 		if (opts.on_build_stop)
 			opts.on_build_stop(opts.userdata, (program ? nytrue : nyfalse));
 		if (not compdb->messages.entries.empty())
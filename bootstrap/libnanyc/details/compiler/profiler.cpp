@@ -0,0 +1,127 @@
+#include "details/compiler/profiler.h"
+#include "details/atom/atom-map.h"
+#include <algorithm>
+#include <ctime>
+
+namespace ny::compiler {
+
+namespace {
+
+//! CPU time consumed by the calling thread, in nanoseconds (0 if not available)
+uint64_t threadCPUTime() {
+	#if defined(YUNI_OS_UNIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+	struct timespec ts;
+	if (0 == clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+	#endif
+	return 0;
+}
+
+} // namespace
+
+Profiler::Profiler(const nycompile_opts_t& opts)
+	: m_opts(opts)
+	, m_enabled(opts.on_profile != nullptr) {
+}
+
+Profiler::Mark Profiler::start() const {
+	Mark mark;
+	if (m_enabled) {
+		mark.wall = std::chrono::steady_clock::now();
+		mark.cpu = threadCPUTime();
+		if (m_opts.allocation_count)
+			mark.allocations = m_opts.allocation_count(m_opts.userdata);
+	}
+	return mark;
+}
+
+Profiler::Entry Profiler::measure(nycompile_phase_t phase, const Mark& since, Mark& now) const {
+	now = start();
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now.wall - since.wall);
+	Entry entry;
+	entry.phase = phase;
+	entry.atomid = 0;
+	entry.count = 1;
+	entry.wall = static_cast<uint64_t>(elapsed.count());
+	entry.cpu = (now.cpu >= since.cpu) ? now.cpu - since.cpu : 0;
+	entry.self = entry.wall;
+	entry.allocations = (now.allocations >= since.allocations) ? now.allocations - since.allocations : 0;
+	return entry;
+}
+
+Profiler::Mark Profiler::add(nycompile_phase_t phase, const Mark& since, const AnyString& name) {
+	if (not m_enabled)
+		return since;
+	Mark now;
+	auto entry = measure(phase, since, now);
+	entry.name = name;
+	yuni::MutexLocker locker{m_mutex};
+	m_entries.push_back(entry);
+	return now;
+}
+
+Profiler::Mark Profiler::beginInstanciation() {
+	if (m_enabled)
+		m_nested.push_back(0);
+	return start();
+}
+
+void Profiler::endInstanciation(uint32_t atomid, const Mark& since) {
+	if (not m_enabled or m_nested.empty())
+		return;
+	Mark now;
+	auto entry = measure(nycompile_phase_instanciate, since, now);
+	uint64_t nested = m_nested.back();
+	m_nested.pop_back();
+	entry.self = (entry.wall > nested) ? entry.wall - nested : 0;
+	if (not m_nested.empty())
+		m_nested.back() += entry.wall;
+	auto it = m_atoms.find(atomid);
+	if (it == m_atoms.end()) {
+		entry.atomid = atomid;
+		m_atoms.emplace(atomid, entry);
+		return;
+	}
+	auto& total = it->second;
+	total.count += 1;
+	total.wall += entry.wall;
+	total.cpu += entry.cpu;
+	total.self += entry.self;
+	total.allocations += entry.allocations;
+}
+
+void Profiler::report(const AtomMap& atoms) const {
+	if (not m_enabled)
+		return;
+	auto emit = [&](const Entry& entry, const AnyString& name) {
+		nycompile_profile_t profile;
+		profile.phase = entry.phase;
+		profile.name.c_str = name.c_str();
+		profile.name.len = name.size();
+		profile.atomid = entry.atomid;
+		profile.count = entry.count;
+		profile.wall_ns = entry.wall;
+		profile.cpu_ns = entry.cpu;
+		profile.self_ns = entry.self;
+		profile.allocations = entry.allocations;
+		m_opts.on_profile(m_opts.userdata, &profile);
+	};
+	for (auto& entry: m_entries)
+		emit(entry, entry.name);
+	// the atoms, in the order of their creation
+	std::vector<const Entry*> list;
+	list.reserve(m_atoms.size());
+	for (auto& it: m_atoms)
+		list.push_back(&it.second);
+	std::sort(list.begin(), list.end(), [](const Entry* a, const Entry* b) { return a->atomid < b->atomid; });
+	yuni::String name;
+	for (auto* entry: list) {
+		auto atom = atoms.findAtom(entry->atomid);
+		name.clear();
+		if (!!atom)
+			name = atom->fullname();
+		emit(*entry, name);
+	}
+}
+
+} // ny::compiler
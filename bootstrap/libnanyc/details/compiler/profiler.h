@@ -0,0 +1,81 @@
+#pragma once
+#include <nanyc/program.h>
+#include <yuni/yuni.h>
+#include <yuni/core/string.h>
+#include <yuni/thread/mutex.h>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+namespace ny { struct AtomMap; }
+
+namespace ny::compiler {
+
+/*!
+** \brief Measures of the compilation phases, per source file and per atom
+**
+** Enabled only if `nycompile_opts_t.on_profile` is provided, all methods are
+** no-ops otherwise. The measures are kept until the end of the compilation and
+** are then given one by one to the callback, from the calling thread.
+*/
+struct Profiler final {
+	//! Start of a measure
+	struct Mark final {
+		std::chrono::steady_clock::time_point wall;
+		uint64_t cpu = 0;
+		uint64_t allocations = 0;
+	};
+
+	explicit Profiler(const nycompile_opts_t&);
+	Profiler(const Profiler&) = delete;
+	Profiler& operator = (const Profiler&) = delete;
+
+	//! Get if the profiling is enabled
+	bool enabled() const { return m_enabled; }
+
+	//! Start a new measure
+	Mark start() const;
+
+	/*!
+	** \brief Add a measure for a phase (thread-safe)
+	**
+	** \param name Filename of the source, if any (must remain valid until the report)
+	** \return The start of the next measure (now)
+	*/
+	Mark add(nycompile_phase_t phase, const Mark& since, const AnyString& name = nullptr);
+
+	//! Start the instanciation of an atom (the instanciations are nested)
+	Mark beginInstanciation();
+	//! End the instanciation of an atom (not thread-safe, like the semantic analysis)
+	void endInstanciation(uint32_t atomid, const Mark& since);
+
+	//! Give all measures to `nycompile_opts_t.on_profile`
+	void report(const AtomMap&) const;
+
+private:
+	struct Entry final {
+		nycompile_phase_t phase;
+		AnyString name;
+		uint32_t atomid;
+		uint32_t count;
+		uint64_t wall;
+		uint64_t cpu;
+		uint64_t self;
+		uint64_t allocations;
+	};
+	Entry measure(nycompile_phase_t, const Mark& since, Mark& now) const;
+
+private:
+	const nycompile_opts_t& m_opts;
+	bool m_enabled = false;
+	//! All measures, except instanciations
+	std::vector<Entry> m_entries;
+	//! Instanciations, per atom id
+	std::unordered_map<uint32_t, Entry> m_atoms;
+	//! Elapsed time of the nested instanciations, per level
+	std::vector<uint64_t> m_nested;
+	yuni::Mutex m_mutex;
+
+}; // struct Profiler
+
+} // ny::compiler
@@ -2,6 +2,25 @@
 
 namespace ny::intrinsic {
 
+namespace {
+
+static_assert(sizeof(nyvalue_t) == sizeof(ny::vm::Register), "nyvalue_t and registers must share the same layout");
+static_assert(static_cast<uint32_t>(nyt_f64) == static_cast<uint32_t>(CType::t_f64), "nytype_t and CType mismatch");
+static_assert(static_cast<uint32_t>(nyt_ptr) == static_cast<uint32_t>(CType::t_ptr), "nytype_t and CType mismatch");
+
+using HostCallback = void (*)(nyvmthread_t*, const nyvalue_t*, nyvalue_t*);
+
+void hostTrampoline(void* callback, nyvmthread_t* tctx, const ny::vm::Register* params, ny::vm::Register& ret) {
+	reinterpret_cast<HostCallback>(callback)(tctx,
+		reinterpret_cast<const nyvalue_t*>(params), reinterpret_cast<nyvalue_t*>(&ret));
+}
+
+bool isValidHostType(nytype_t type, bool allowVoid) {
+	return (type == nyt_void) ? allowVoid : (type != nyt_any and type <= nyt_f64);
+}
+
+} // namespace
+
 Catalog::Catalog() {
 	m_intrinsics.reserve(128);
 }
@@ -15,4 +34,25 @@ Intrinsic& Catalog::makeIntrinsic(const AnyString& name, void* callback) {
 	return intrinsic;
 }
 
+bool Catalog::emplace(const nyintrinsic_t& host) {
+	AnyString name{host.name.c_str, static_cast<uint32_t>(host.name.len)};
+	bool valid = not name.empty() and name.size() < Name::chunkSize
+		and host.callback != nullptr
+		and isValidHostType(host.rettype, true)
+		and host.paramcount < config::maxPushedParameters
+		and (host.paramcount == 0 or host.params != nullptr)
+		and not exists(name);
+	for (uint32_t i = 0; valid and i != host.paramcount; ++i)
+		valid = isValidHostType(host.params[i], false);
+	if (unlikely(not valid))
+		return false;
+	auto& intrinsic = makeIntrinsic(name, reinterpret_cast<void*>(host.callback));
+	intrinsic.trampoline = &hostTrampoline;
+	intrinsic.rettype = static_cast<CType>(host.rettype);
+	intrinsic.paramcount = host.paramcount;
+	for (uint32_t i = 0; i != host.paramcount; ++i)
+		intrinsic.params[i] = static_cast<CType>(host.params[i]);
+	return true;
+}
+
 } // ny::intrinsic
@@ -3,6 +3,7 @@
 #include <yuni/core/bind.h>
 #include "details/intrinsic/intrinsic.h"
 #include "nanyc/vm.h"
+#include "nanyc/program.h"
 #include <unordered_map>
 #include <vector>
 #include <memory>
@@ -18,6 +19,11 @@ struct Catalog final {
 	//! Add a new intrinsic
 	// (no check performed if already exists)
 	template<class T> void emplace(const AnyString& name, T callback);
+	/*!
+	** \brief Add a new intrinsic provided by the host (see `nycompile_opts_t.intrinsics`)
+	** \return False if the intrinsic is invalid or already exists
+	*/
+	bool emplace(const nyintrinsic_t&);
 
 	//! Get if an intrinsic exists
 	bool exists(const AnyString& name) const;
@@ -2,6 +2,8 @@
 #include "catalog.h"
 #include <yuni/core/static/types.h>
 #include "details/atom/ctype.h"
+#include <type_traits>
+#include <utility>
 
 namespace ny::intrinsic {
 
@@ -75,6 +77,54 @@ template<uint N, class T> struct IntrinsicPushParameter<N, N, T> final {
 	static void push(Intrinsic&) {}
 };
 
+//! Read / write a C++ value from / to a register (same convertions than the VM)
+template<class T, class Enable = void> struct RegisterCast final {
+	static_assert(std::is_pointer<T>::value, "unsupported intrinsic type");
+	static T from(const ny::vm::Register& r) { return reinterpret_cast<T>(r.u64); }
+	static void to(ny::vm::Register& r, T value) { r.u64 = reinterpret_cast<uint64_t>(value); }
+};
+
+template<class T>
+struct RegisterCast<T, typename std::enable_if<std::is_integral<T>::value and std::is_unsigned<T>::value>::type> final {
+	static T from(const ny::vm::Register& r) { return static_cast<T>(r.u64); }
+	static void to(ny::vm::Register& r, T value) { r.u64 = static_cast<uint64_t>(value); }
+};
+
+template<class T>
+struct RegisterCast<T, typename std::enable_if<std::is_integral<T>::value and std::is_signed<T>::value>::type> final {
+	static T from(const ny::vm::Register& r) { return static_cast<T>(r.i64); }
+	static void to(ny::vm::Register& r, T value) { r.i64 = static_cast<int64_t>(value); }
+};
+
+template<class T>
+struct RegisterCast<T, typename std::enable_if<std::is_floating_point<T>::value>::type> final {
+	static T from(const ny::vm::Register& r) { return static_cast<T>(r.f64); }
+	static void to(ny::vm::Register& r, T value) { r.f64 = static_cast<double>(value); }
+};
+
+template<class T> struct IntrinsicTrampoline {};
+
+template<class R, class... Args> struct IntrinsicTrampoline<R (*)(nyvmthread_t*, Args...)> final {
+	using Callback = R (*)(nyvmthread_t*, Args...);
+
+	static void call(void* callback, nyvmthread_t* tctx, const ny::vm::Register* params, ny::vm::Register& ret) {
+		invoke(reinterpret_cast<Callback>(callback), tctx, params, ret, std::index_sequence_for<Args...>{});
+	}
+
+private:
+	template<std::size_t... I>
+	static void invoke(Callback callback, nyvmthread_t* tctx, const ny::vm::Register* params,
+			ny::vm::Register& ret, std::index_sequence<I...>) {
+		(void) params; // no parameter
+		if constexpr (std::is_void<R>::value) {
+			(void) ret;
+			callback(tctx, RegisterCast<Args>::from(params[I])...);
+		}
+		else
+			RegisterCast<R>::to(ret, callback(tctx, RegisterCast<Args>::from(params[I])...));
+	}
+};
+
 template<class T>
 inline void Catalog::emplace(const AnyString& name, T callback) {
 	assert(not name.empty());
@@ -83,6 +133,7 @@ inline void Catalog::emplace(const AnyString& name, T callback) {
 	using B = Yuni::Bind<T>;
 	static_assert(B::argumentCount < config::maxPushedParameters, "too many params");
 	auto& intrinsic = makeIntrinsic(name, reinterpret_cast<void*>(callback));
+	intrinsic.trampoline = &IntrinsicTrampoline<T>::call;
 	if (B::hasReturnValue)
 		intrinsic.rettype = CTypeToNanyType<typename B::ReturnType>::type;
 	// the first argument must be the thread context
@@ -5,15 +5,27 @@
 #include "libnanyc-config.h"
 #include <array>
 #include "details/atom/ctype.h"
+#include "details/vm/types.h"
+#include "nanyc/vm.h"
 
 namespace ny::intrinsic {
 
 //! Definition of a single user-defined intrinsic
 struct Intrinsic final {
+	/*!
+	** \brief Direct call to the C-callback, specialized for its signature
+	**
+	** The parameters are read directly from the registers of the VM and the
+	** returned value is written into `ret` (untouched if void).
+	*/
+	using Trampoline = void (*)(void* callback, nyvmthread_t*, const ny::vm::Register* params, ny::vm::Register& ret);
+
 	Intrinsic(void* callback, uint32_t id): callback(callback), id(id) {}
 
 	//! C-Callback
 	void* callback = nullptr;
+	//! Direct call, if the signature is known at compile time (dyncall otherwise)
+	Trampoline trampoline = nullptr;
 	//! Intrinsic ID
 	const uint32_t id;
 	//! The return type
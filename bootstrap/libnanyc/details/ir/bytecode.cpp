@@ -0,0 +1,163 @@
+#include "bytecode.h"
+#include <algorithm>
+
+namespace ny::ir {
+
+static_assert(static_cast<uint32_t>(isa::Op::end) <= 0xFF, "the opcodes must be encoded with 1 byte");
+
+namespace {
+
+//! Get if the labels are unique within a sequence (and the greatest label id)
+bool labelsAreUnique(const Sequence& sequence, uint32_t& upperLabel) {
+	uint32_t count = sequence.opcodeCount();
+	upperLabel = 0;
+	for (uint32_t i = 0; i != count; ++i) {
+		auto& instr = sequence.at(i);
+		if (instr.opcodes[0] == static_cast<uint32_t>(isa::Op::label))
+			upperLabel = std::max(upperLabel, instr.to<isa::Op::label>().label);
+	}
+	std::vector<bool> found(upperLabel + 1, false);
+	for (uint32_t i = 0; i != count; ++i) {
+		auto& instr = sequence.at(i);
+		if (instr.opcodes[0] == static_cast<uint32_t>(isa::Op::label)) {
+			uint32_t label = instr.to<isa::Op::label>().label;
+			if (found[label])
+				return false;
+			found[label] = true;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+void Bytecode::build(const Sequence& sequence) {
+	m_sequence = &sequence;
+	m_body.clear();
+	m_labels.clear();
+	m_labelPositions.clear();
+	m_debugpos.clear();
+	m_count = 0;
+	uint32_t count = sequence.opcodeCount();
+	m_body.reserve(count * 6); // arbitrary, most instructions have small operands
+	uint32_t upperLabel;
+	bool indexed = labelsAreUnique(sequence, upperLabel);
+	if (indexed)
+		m_labels.resize(upperLabel + 1, 0u);
+	uint32_t filename = 0;
+	uint32_t i = 0;
+	if (count != 0 and sequence.at(0).opcodes[0] == static_cast<uint32_t>(isa::Op::stacksize))
+		i = 1; // the stack size is given by the func descriptor
+	for ( ; i < count; ++i) {
+		auto& instr = sequence.at(i);
+		switch (static_cast<isa::Op>(instr.opcodes[0])) {
+			case isa::Op::nop:
+			case isa::Op::comment:
+			case isa::Op::scope:
+			case isa::Op::end:
+			case isa::Op::stackalloc:
+			case isa::Op::namealias:
+				break;
+			case isa::Op::debugfile: {
+				filename = instr.to<isa::Op::debugfile>().filename;
+				break;
+			}
+			case isa::Op::debugpos: {
+				auto& operands = instr.to<isa::Op::debugpos>();
+				uint32_t offset = size();
+				if (not m_debugpos.empty() and m_debugpos.back().offset == offset)
+					m_debugpos.pop_back(); // no instruction for the previous position
+				m_debugpos.push_back(DebugPos{offset, filename, operands.line, operands.offset});
+				break;
+			}
+			case isa::Op::label: {
+				uint32_t label = instr.to<isa::Op::label>().label;
+				if (indexed) {
+					m_labels[label] = size() + 1;
+					break;
+				}
+				encode(instr); // required by the forward/backward search
+				m_labelPositions.emplace_back(label, size());
+				break;
+			}
+			default: {
+				encode(instr);
+				break;
+			}
+		}
+	}
+	m_body.shrink_to_fit();
+}
+
+void Bytecode::encode(const Instruction& instr) {
+	uint32_t n = operandCount(static_cast<isa::Op>(instr.opcodes[0]));
+	uint32_t upper = 0;
+	for (uint32_t i = 1; i <= n; ++i)
+		upper = std::max(upper, instr.opcodes[i]);
+	uint8_t width = (upper <= 0xFFu) ? 1 : ((upper <= 0xFFFFu) ? 2 : 4);
+	size_t offset = m_body.size();
+	m_body.resize(offset + 2 + n * width);
+	uint8_t* out = m_body.data() + offset;
+	out[0] = static_cast<uint8_t>(instr.opcodes[0]);
+	out[1] = width;
+	out += 2;
+	for (uint32_t i = 0; i != n; ++i) {
+		uint32_t value = instr.opcodes[i + 1];
+		switch (width) {
+			case 1: {
+				out[i] = static_cast<uint8_t>(value);
+				break;
+			}
+			case 2: {
+				uint16_t value16 = static_cast<uint16_t>(value);
+				memcpy(out + i * sizeof(uint16_t), &value16, sizeof(uint16_t));
+				break;
+			}
+			default: {
+				memcpy(out + i * sizeof(uint32_t), &value, sizeof(uint32_t));
+				break;
+			}
+		}
+	}
+	++m_count;
+}
+
+bool Bytecode::jumpToLabel(const uint8_t*& cursor, uint32_t label, bool forward) const {
+	if (likely(m_labelPositions.empty())) {
+		if (likely(label < m_labels.size())) {
+			uint32_t offset = m_labels[label];
+			if (likely(offset != 0)) {
+				cursor = m_body.data() + (offset - 1);
+				return true;
+			}
+		}
+		return false;
+	}
+	// the cursor is already after the jump
+	uint32_t current = offsetOf(cursor);
+	if (forward) {
+		for (auto& position: m_labelPositions) {
+			if (position.first == label and position.second > current) {
+				cursor = m_body.data() + position.second;
+				return true;
+			}
+		}
+	}
+	else {
+		for (auto it = m_labelPositions.rbegin(); it != m_labelPositions.rend(); ++it) {
+			if (it->first == label and it->second < current) {
+				cursor = m_body.data() + it->second;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+const Bytecode::DebugPos* Bytecode::findDebugPos(uint32_t offset) const {
+	auto it = std::upper_bound(m_debugpos.begin(), m_debugpos.end(), offset,
+		[](uint32_t offset, const DebugPos& pos) { return offset < pos.offset; });
+	return (it != m_debugpos.begin()) ? &(*(it - 1)) : nullptr;
+}
+
+} // ny::ir
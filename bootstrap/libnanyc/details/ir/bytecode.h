@@ -0,0 +1,108 @@
+#pragma once
+#include "libnanyc.h"
+#include "details/ir/sequence.h"
+#include <utility>
+#include <vector>
+
+namespace ny::ir {
+
+/*!
+** \brief Compact runtime encoding of a finalized IR sequence, executed by the VM
+**
+** Each instruction is encoded as its opcode (1 byte), the width of its
+** operands (1 byte: 1, 2 or 4 bytes) and only its operands, all with the same
+** width (the smallest one able to hold all of them). The opcodes without any
+** effect at runtime (`nop`, `comment`, `scope`, `end`, `stackalloc`) are
+** removed, the debug info (`debugfile`, `debugpos`) is moved to a side table
+** and the labels are removed when they can be indexed (unique within the
+** sequence).
+**
+** The `ir::Sequence` (16 bytes per instruction) remains the form used for
+** compilation. The bytecode must be rebuilt if the sequence is modified.
+*/
+struct Bytecode final {
+	//! Position in the source code of an instruction
+	struct DebugPos final {
+		//! Offset of the first instruction for this position (in bytes)
+		uint32_t offset;
+		//! Source file (index in the stringrefs of the sequence, 0 if unknown)
+		uint32_t filename;
+		uint32_t line;
+		uint32_t column;
+	};
+
+	Bytecode() = default;
+	Bytecode(const Bytecode&) = delete;
+	Bytecode& operator = (const Bytecode&) = delete;
+
+	//! Build the bytecode from a finalized sequence (after instanciation and link)
+	void build(const Sequence&);
+
+	//! \name Cursor manipulation
+	//@{
+	//! Get the offset (in bytes) of a cursor
+	uint32_t offsetOf(const uint8_t* cursor) const;
+	//! Invalidate a cursor (the execution stops)
+	void invalidateCursor(const uint8_t*& cursor) const;
+	/*!
+	** \brief Go to the instruction just after a label
+	**
+	** When the labels are not unique, the label is searched forward or
+	** backward according to the last label reached (see Sequence::jumpToLabelForward())
+	*/
+	bool jumpToLabel(const uint8_t*& cursor, uint32_t label, bool forward) const;
+	//@}
+
+	//! \name Iteration
+	//@{
+	/*!
+	** \brief Visit each instruction from a given offset (in bytes)
+	**
+	** The cursor of the visitor points to the next instruction when an
+	** opcode handler is called. Threaded dispatch is used if available.
+	*/
+	template<class T> void each(T& visitor, uint32_t offset = 0) const;
+	//@}
+
+	//! \name Debug
+	//@{
+	//! Find the position in the source code of an offset (null if unknown)
+	const DebugPos* findDebugPos(uint32_t offset) const;
+	//! The original sequence (strings, printing)
+	const Sequence& sequence() const;
+	//@}
+
+	//! \name Memory Management
+	//@{
+	//! Number of instructions
+	uint32_t opcodeCount() const;
+	//! Size of the bytecode (in bytes)
+	uint32_t size() const;
+	//@}
+
+	//! Number of operands (32 bits words after the opcode) of an opcode
+	static constexpr uint32_t operandCount(isa::Op);
+
+private:
+	template<uint32_t N> static const uint8_t* decode(Instruction& instr, const uint8_t* it);
+	void encode(const Instruction&);
+
+private:
+	//! The encoded instructions
+	std::vector<uint8_t> m_body;
+	//! Label index: label id -> offset of the next instruction + 1 (0 if the label does not exist)
+	std::vector<uint32_t> m_labels;
+	//! All labels {label id, offset of the next instruction}, when they are not unique
+	std::vector<std::pair<uint32_t, uint32_t>> m_labelPositions;
+	//! Positions in the source code, ordered by offset
+	std::vector<DebugPos> m_debugpos;
+	//! Number of instructions
+	uint32_t m_count = 0;
+	//! The original sequence
+	const Sequence* m_sequence = nullptr;
+
+}; // Bytecode
+
+} // ny::ir
+
+#include "bytecode.hxx"
@@ -0,0 +1,115 @@
+#pragma once
+#include "bytecode.h"
+#include <cstring>
+
+namespace ny::ir {
+
+inline constexpr uint32_t Bytecode::operandCount(isa::Op opcode) {
+	switch (opcode) {
+		#define LIBNANYC_IR_OPERAND_COUNT(OPCODE) \
+		case isa::Op::OPCODE: \
+			return static_cast<uint32_t>(sizeof(isa::Operand<isa::Op::OPCODE>) / sizeof(uint32_t)) - 1;
+		LIBNANYC_IR_EACH_OPCODE(LIBNANYC_IR_OPERAND_COUNT)
+		#undef LIBNANYC_IR_OPERAND_COUNT
+	}
+	return 3;
+}
+
+inline uint32_t Bytecode::opcodeCount() const {
+	return m_count;
+}
+
+inline uint32_t Bytecode::size() const {
+	return static_cast<uint32_t>(m_body.size());
+}
+
+inline const Sequence& Bytecode::sequence() const {
+	assert(m_sequence != nullptr);
+	return *m_sequence;
+}
+
+inline uint32_t Bytecode::offsetOf(const uint8_t* cursor) const {
+	assert(cursor >= m_body.data() and cursor <= m_body.data() + m_body.size());
+	return static_cast<uint32_t>(cursor - m_body.data());
+}
+
+inline void Bytecode::invalidateCursor(const uint8_t*& cursor) const {
+	cursor = m_body.data() + m_body.size();
+}
+
+template<uint32_t N>
+inline const uint8_t* Bytecode::decode(Instruction& instr, const uint8_t* it) {
+	instr.opcodes[0] = it[0];
+	uint32_t width = it[1];
+	it += 2;
+	switch (width) {
+		case 1: {
+			for (uint32_t i = 0; i != N; ++i)
+				instr.opcodes[i + 1] = it[i];
+			break;
+		}
+		case 2: {
+			for (uint32_t i = 0; i != N; ++i) {
+				uint16_t value;
+				memcpy(&value, it + i * sizeof(uint16_t), sizeof(uint16_t));
+				instr.opcodes[i + 1] = value;
+			}
+			break;
+		}
+		default: {
+			memcpy(&instr.opcodes[1], it, N * sizeof(uint32_t));
+			break;
+		}
+	}
+	return it + N * width;
+}
+
+template<class T> inline void Bytecode::each(T& visitor, uint32_t offset) const {
+	if (unlikely(not (offset < m_body.size())))
+		return;
+	const uint8_t* it = m_body.data() + offset;
+	const uint8_t* const end = m_body.data() + m_body.size();
+	visitor.cursor = &it;
+	alignas(8) Instruction instr; // the decoded instruction (some operands have 64bits members)
+	#if LIBNANYC_IR_THREADED_DISPATCH != 0
+	#define LIBNANYC_IR_BYTECODE_ADDR(OPCODE)  &&bytecode_##OPCODE,
+	static const void* const dispatch[] = {
+		LIBNANYC_IR_EACH_OPCODE(LIBNANYC_IR_BYTECODE_ADDR)
+	};
+	#undef LIBNANYC_IR_BYTECODE_ADDR
+	static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == 1 + static_cast<uint32_t>(isa::Op::end),
+		"the dispatch table must contain all opcodes");
+	assert(*it <= static_cast<uint32_t>(isa::Op::end));
+	goto *dispatch[*it];
+	// the cursor is moved to the next instruction before calling the handler
+	// (a jump simply replaces it)
+	#define LIBNANYC_IR_BYTECODE_HANDLER(OPCODE) \
+	bytecode_##OPCODE: \
+		it = decode<operandCount(isa::Op::OPCODE)>(instr, it); \
+		visitor.visit(reinterpret_cast<const isa::Operand<isa::Op::OPCODE>&>(instr)); \
+		if (likely(it < end)) { \
+			assert(*it <= static_cast<uint32_t>(isa::Op::end)); \
+			goto *dispatch[*it]; \
+		} \
+		return;
+	LIBNANYC_IR_EACH_OPCODE(LIBNANYC_IR_BYTECODE_HANDLER)
+	#undef LIBNANYC_IR_BYTECODE_HANDLER
+	#else
+	do {
+		assert(*it <= static_cast<uint32_t>(isa::Op::end));
+		switch (static_cast<isa::Op>(*it)) {
+			#define LIBNANYC_IR_BYTECODE_CASE(OPCODE) \
+			case isa::Op::OPCODE: { \
+				it = decode<operandCount(isa::Op::OPCODE)>(instr, it); \
+				visitor.visit(reinterpret_cast<const isa::Operand<isa::Op::OPCODE>&>(instr)); \
+				break; \
+			}
+			LIBNANYC_IR_EACH_OPCODE(LIBNANYC_IR_BYTECODE_CASE)
+			#undef LIBNANYC_IR_BYTECODE_CASE
+		}
+	}
+	while (it < end);
+	#endif
+}
+
+} // ny::ir
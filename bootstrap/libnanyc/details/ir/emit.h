@@ -318,6 +318,7 @@ inline void unref(IRCodeRef ref, uint32_t lvid, uint32_t atomid) {
 	auto& operands = ref.ircode.emit<isa::Op::unref>();
 	operands.lvid = lvid;
 	operands.atomid = atomid;
+	operands.dtor = (uint32_t) -1;
 }
 
 inline void scopeBegin(IRCodeRef ref) {
@@ -425,6 +426,19 @@ inline void call(IRCodeRef ref, uint32_t lvid, uint32_t atomid, uint32_t instanc
 	operands.instanceid = instanceid;
 }
 
+//! The next func call (result: 'lvid') is asynchronous
+inline void async(IRCodeRef ref, uint32_t lvid) {
+	ref.ircode.emit<isa::Op::async>().lvid = lvid;
+}
+
+inline void spawn(IRCodeRef ref, uint32_t lvid, uint32_t atomid, uint32_t instanceid) {
+	assert(instanceid != (uint32_t) - 1);
+	auto& operands = ref.ircode.emit<isa::Op::spawn>();
+	operands.lvid  = lvid;
+	operands.ptr2func = atomid;
+	operands.instanceid = instanceid;
+}
+
 inline void intrinsic(IRCodeRef ref, uint32_t lvid, const AnyString& name, uint32_t id = (uint32_t) - 1) {
 	auto& operands     = ref.ircode.emit<isa::Op::intrinsic>();
 	operands.lvid      = lvid;
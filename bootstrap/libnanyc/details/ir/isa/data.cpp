@@ -34,8 +34,11 @@ void printExtract(YString& out, const Sequence& ircode, uint32_t offset, const A
 AnyString opname(ny::ir::isa::Op opcode) {
 	switch (opcode) {
 		case Op::add:            return "add";
+		case Op::addimm:         return "addimm";
 		case Op::allocate:       return "allocate";
 		case Op::assign:         return "assign";
+		case Op::async:          return "async";
+		case Op::await:          return "await";
 		case Op::blueprint:      return "blueprint";
 		case Op::call:           return "call";
 		case Op::as:             return "as";
@@ -54,6 +57,7 @@ AnyString opname(ny::ir::isa::Op opcode) {
 		case Op::fgt:            return "fgt";
 		case Op::fgte:           return "fgte";
 		case Op::fieldget:       return "fieldget";
+		case Op::fcall:          return "fcall";
 		case Op::fieldset:       return "fieldset";
 		case Op::flt:            return "flt";
 		case Op::flte:           return "flte";
@@ -75,6 +79,13 @@ AnyString opname(ny::ir::isa::Op opcode) {
 		case Op::jmperrhandler:  return "jmperrhandler";
 		case Op::jnz:            return "jnz";
 		case Op::jz:             return "jz";
+		case Op::jzeq:           return "jzeq";
+		case Op::jzfield:        return "jzfield";
+		case Op::jzilt:          return "jzilt";
+		case Op::jzilte:         return "jzilte";
+		case Op::jzlt:           return "jzlt";
+		case Op::jzlte:          return "jzlte";
+		case Op::jzneq:          return "jzneq";
 		case Op::jzraise:        return "jzraise";
 		case Op::label:          return "label";
 		case Op::load_u32:       return "load_u32";
@@ -111,6 +122,7 @@ AnyString opname(ny::ir::isa::Op opcode) {
 		case Op::scope:          return "scope";
 		case Op::self:           return "self";
 		case Op::stackalloc:     return "stackalloc";
+		case Op::spawn:          return "spawn";
 		case Op::stacksize:      return "stacksize";
 		case Op::store:          return "store";
 		case Op::store_u32:      return "store_u32";
@@ -119,9 +131,11 @@ AnyString opname(ny::ir::isa::Op opcode) {
 		case Op::storeConstant:  return "storeConstant";
 		case Op::storeText:      return "storeText";
 		case Op::sub:            return "sub";
+		case Op::subimm:         return "subimm";
 		case Op::tpush:          return "tpush";
 		case Op::typeisobject:   return "typeisobject";
 		case Op::unref:          return "unref";
+		case Op::unrefrange:     return "unrefrange";
 	}
 	throw "internal error";
 }
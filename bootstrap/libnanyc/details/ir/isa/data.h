@@ -527,6 +527,34 @@ template<> struct Operand<ny::ir::isa::Op::call> final {
 	}
 };
 
+template<> struct Operand<ny::ir::isa::Op::fcall> final {
+	uint32_t opcode;
+	uint32_t lvid;
+	uint32_t func; // index in the table of linked functions
+	uint32_t atomid; // for debugging purposes
+	template<class T> void eachLVID(const T& c) {
+		c(lvid);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::spawn> final {
+	uint32_t opcode;
+	uint32_t lvid; // job, then result after 'await'
+	uint32_t ptr2func; // atomid
+	uint32_t instanceid;
+	template<class T> void eachLVID(const T& c) {
+		c(lvid, ptr2func);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::await> final {
+	uint32_t opcode;
+	uint32_t lvid;
+	template<class T> void eachLVID(const T& c) {
+		c(lvid);
+	}
+};
+
 template<> struct Operand<ny::ir::isa::Op::intrinsic> final {
 	uint32_t opcode;
 	uint32_t lvid;
@@ -601,6 +629,96 @@ template<> struct Operand<ny::ir::isa::Op::memcheckhold> final {
 	}
 };
 
+template<> struct Operand<ny::ir::isa::Op::addimm> final {
+	uint32_t opcode;
+	uint32_t lvid;
+	uint32_t lhs;
+	uint32_t value; // immediate value
+	template<class T> void eachLVID(const T& c) {
+		c(lvid, lhs);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::subimm> final {
+	uint32_t opcode;
+	uint32_t lvid;
+	uint32_t lhs;
+	uint32_t value; // immediate value
+	template<class T> void eachLVID(const T& c) {
+		c(lvid, lhs);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzeq> final {
+	uint32_t opcode;
+	uint32_t lhs;
+	uint32_t rhs;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(lhs, rhs, label);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzneq> final {
+	uint32_t opcode;
+	uint32_t lhs;
+	uint32_t rhs;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(lhs, rhs, label);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzlt> final {
+	uint32_t opcode;
+	uint32_t lhs;
+	uint32_t rhs;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(lhs, rhs, label);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzilt> final {
+	uint32_t opcode;
+	uint32_t lhs;
+	uint32_t rhs;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(lhs, rhs, label);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzlte> final {
+	uint32_t opcode;
+	uint32_t lhs;
+	uint32_t rhs;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(lhs, rhs, label);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzilte> final {
+	uint32_t opcode;
+	uint32_t lhs;
+	uint32_t rhs;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(lhs, rhs, label);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::jzfield> final {
+	uint32_t opcode;
+	uint32_t self;
+	uint32_t var;
+	uint32_t label;
+	template<class T> void eachLVID(const T& c) {
+		c(self, label);
+	}
+};
+
 template<> struct Operand<ny::ir::isa::Op::label> final {
 	uint32_t opcode;
 	uint32_t label;
@@ -901,6 +1019,14 @@ template<> struct Operand<ny::ir::isa::Op::ensureresolved> final {
 	}
 };
 
+template<> struct Operand<ny::ir::isa::Op::async> final {
+	uint32_t opcode;
+	uint32_t lvid;
+	template<class T> void eachLVID(const T& c) {
+		c(lvid);
+	}
+};
+
 template<> struct Operand<ny::ir::isa::Op::commontype> final {
 	uint32_t opcode;
 	uint32_t lvid;
@@ -959,6 +1085,18 @@ template<> struct Operand<ny::ir::isa::Op::unref> final {
 	uint32_t opcode;
 	uint32_t lvid;
 	uint32_t atomid;
+	uint32_t dtor; // index of the linked dtor, (uint32_t) -1 if not linked
+
+	template<class T> void eachLVID(const T& c) {
+		c(lvid);
+	}
+};
+
+template<> struct Operand<ny::ir::isa::Op::unrefrange> final {
+	uint32_t opcode;
+	uint32_t lvid;  // first register of the range
+	uint32_t count; // number of registers, released in the reverse order
+	uint32_t dtor;  // index of the linked dtor (always trivial)
 
 	template<class T> void eachLVID(const T& c) {
 		c(lvid);
@@ -63,8 +63,12 @@ enum class Op : std::uint32_t {
 
 	ref,            ///< increment the reference count
 	unref,          ///< decrement the reference count (release it if reaches 0)
+	unrefrange,     ///< unref a range of registers, released by a trivial dtor (see `ny::compiler::link()`)
 	push,           ///< push indexed or named parameter for next function call
 	call,           ///< function call
+	fcall,          ///< direct call to a linked function (see `ny::compiler::link()`)
+	spawn,          ///< asynchronous function call (job)
+	await,          ///< wait for the result of an asynchronous function call
 	intrinsic,      ///< compiler intrinsic call
 	ret,            ///< return
 	raise,          ///< raise an error
@@ -92,11 +96,22 @@ enum class Op : std::uint32_t {
 	opassert,       ///< assert if expr is false
 	memcheckhold,   ///< mark a pointer as valid (MemChecker)
 
+	// --- superinstructions (generated by the peephole pass only)
+	addimm,         ///< + (immediate value)
+	subimm,         ///< - (immediate value)
+	jzeq,           ///< jump if not equal
+	jzneq,          ///< jump if equal
+	jzlt,           ///< jump if not less than
+	jzilt,          ///< jump if not less than (signed)
+	jzlte,          ///< jump if not less than or equal
+	jzilte,         ///< jump if not less than or equal (signed)
+	jzfield,        ///< jump if the variable member is zero
 
 	// --- opcodes for compilation only
 	identify,       ///< resolve an identifier completely or partially (if overload)
 	identifyset,    ///< like 'identify', but perfers setters instead of getters
 	ensureresolved, ///< resolve completely type of expr (if not done by 'identify')
+	async,          ///< the previous func call (result) must be asynchronous
 	commontype,     ///< determine common type
 	assign,         ///< assign a variable to another
 	self,           ///< declare a register as 'self'
@@ -119,6 +134,135 @@ enum class Op : std::uint32_t {
 };
 
 
+/*!
+** \brief All opcodes, in the same order than the enum `Op`
+**
+** \code
+** #define MY_MACRO(OPCODE)  std::cout << #OPCODE << '\n';
+** LIBNANYC_IR_EACH_OPCODE(MY_MACRO)
+** \endcode
+*/
+#define LIBNANYC_IR_EACH_OPCODE(MACRO) \
+	MACRO(nop) \
+	MACRO(opand) \
+	MACRO(opor) \
+	MACRO(opxor) \
+	MACRO(opmod) \
+	MACRO(opmodi) \
+	MACRO(eq) \
+	MACRO(neq) \
+	MACRO(lt) \
+	MACRO(ilt) \
+	MACRO(lte) \
+	MACRO(ilte) \
+	MACRO(gt) \
+	MACRO(igt) \
+	MACRO(gte) \
+	MACRO(igte) \
+	MACRO(flt) \
+	MACRO(flte) \
+	MACRO(fgt) \
+	MACRO(fgte) \
+	MACRO(negation) \
+	MACRO(add) \
+	MACRO(sub) \
+	MACRO(mul) \
+	MACRO(div) \
+	MACRO(imul) \
+	MACRO(idiv) \
+	MACRO(fadd) \
+	MACRO(fsub) \
+	MACRO(fmul) \
+	MACRO(fdiv) \
+	MACRO(storeConstant) \
+	MACRO(store) \
+	MACRO(storeText) \
+	MACRO(stackalloc) \
+	MACRO(as) \
+	MACRO(jmp) \
+	MACRO(jz) \
+	MACRO(jnz) \
+	MACRO(jzraise) \
+	MACRO(jmperrhandler) \
+	MACRO(ref) \
+	MACRO(unref) \
+	MACRO(unrefrange) \
+	MACRO(push) \
+	MACRO(call) \
+	MACRO(fcall) \
+	MACRO(spawn) \
+	MACRO(await) \
+	MACRO(intrinsic) \
+	MACRO(ret) \
+	MACRO(raise) \
+	MACRO(allocate) \
+	MACRO(stacksize) \
+	MACRO(pragma) \
+	MACRO(load_u64) \
+	MACRO(load_u32) \
+	MACRO(load_u8) \
+	MACRO(store_u64) \
+	MACRO(store_u32) \
+	MACRO(store_u8) \
+	MACRO(memalloc) \
+	MACRO(memfree) \
+	MACRO(memrealloc) \
+	MACRO(memfill) \
+	MACRO(memcopy) \
+	MACRO(memmove) \
+	MACRO(memcmp) \
+	MACRO(cstrlen) \
+	MACRO(label) \
+	MACRO(opassert) \
+	MACRO(memcheckhold) \
+	MACRO(addimm) \
+	MACRO(subimm) \
+	MACRO(jzeq) \
+	MACRO(jzneq) \
+	MACRO(jzlt) \
+	MACRO(jzilt) \
+	MACRO(jzlte) \
+	MACRO(jzilte) \
+	MACRO(jzfield) \
+	MACRO(identify) \
+	MACRO(identifyset) \
+	MACRO(ensureresolved) \
+	MACRO(async) \
+	MACRO(commontype) \
+	MACRO(assign) \
+	MACRO(self) \
+	MACRO(tpush) \
+	MACRO(follow) \
+	MACRO(blueprint) \
+	MACRO(classdefsizeof) \
+	MACRO(fieldget) \
+	MACRO(fieldset) \
+	MACRO(debugfile) \
+	MACRO(debugpos) \
+	MACRO(namealias) \
+	MACRO(comment) \
+	MACRO(scope) \
+	MACRO(typeisobject) \
+	MACRO(qualifiers) \
+	MACRO(onscopefail) \
+	MACRO(end)
+
+
+/*!
+** \brief Threaded dispatch via computed gotos (labels as values), see `Bytecode::each()`
+**
+** Enabled by default with gcc and clang. Can be disabled with the cmake option
+** `NANYC_VM_THREADED_DISPATCH=OFF` (portable `switch` dispatch)
+*/
+#ifndef LIBNANYC_IR_THREADED_DISPATCH
+#  if defined(__GNUC__)
+#    define LIBNANYC_IR_THREADED_DISPATCH 1
+#  else
+#    define LIBNANYC_IR_THREADED_DISPATCH 0
+#  endif
+#endif
+
+
 #if LIBNANYC_IR_PRINT_OPCODES != 0
 #define __LIBNANYC_IR_PRINT_OPCODE(OPCODE) std::cout << " -- opc " << (void*) this << " -- " << opc << " as " << #OPCODE << std::endl;
 #else
@@ -185,8 +329,12 @@ enum class Op : std::uint32_t {
 			\
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::ref) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::unref) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::unrefrange) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::push) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::call) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::fcall) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::spawn) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::await) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::intrinsic) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::ret) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::raise) \
@@ -214,6 +362,16 @@ enum class Op : std::uint32_t {
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::opassert) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::memcheckhold) \
 			\
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::addimm) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::subimm) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzeq) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzneq) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzlt) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzilt) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzlte) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzilte) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::jzfield) \
+			\
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::tpush) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::follow) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::blueprint) \
@@ -223,6 +381,7 @@ enum class Op : std::uint32_t {
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::identify) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::identifyset) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::ensureresolved) \
+			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::async) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::commontype) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::assign) \
 			LIBNANYC_IR_VISIT_OPCODE(PREFIX, VISITOR, IT, isa::Op::self) \
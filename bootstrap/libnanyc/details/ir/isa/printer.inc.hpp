@@ -308,6 +308,21 @@ template<class S> struct Printer final {
 		}
 	}
 
+	void print(const Operand<Op::fcall>& operands) {
+		line() << '%' << operands.lvid << " = fcall func:" << operands.func;
+		out << " // atom -> " << operands.atomid;
+	}
+
+	void print(const Operand<Op::spawn>& operands) {
+		line() << '%' << operands.lvid << " = spawn atom -> ";
+		out << operands.ptr2func << " #" << operands.instanceid;
+		printAtomInstanceID(operands.ptr2func, operands.instanceid);
+	}
+
+	void print(const Operand<Op::await>& operands) {
+		line() << "await %" << operands.lvid;
+	}
+
 	void print(const Operand<Op::intrinsic>& operands) {
 		line() << '%' << operands.lvid << " = intrinsic ";
 		if (operands.iid != (uint32_t) -1)
@@ -374,6 +389,10 @@ template<class S> struct Printer final {
 		line() << "ensure resolved %" << operands.lvid;
 	}
 
+	void print(const Operand<Op::async>& operands) {
+		line() << "async %" << operands.lvid;
+	}
+
 	void print(const Operand<Op::commontype>& operands) {
 		line() << '%' << operands.lvid << " = common type with %" << operands.previous;
 	}
@@ -523,6 +542,11 @@ template<class S> struct Printer final {
 		}
 	}
 
+	void print(const Operand<Op::unrefrange>& operands) {
+		line() << "-unref %" << operands.lvid << "..%" << (operands.lvid + operands.count - 1);
+		out << " {dtor:" << operands.dtor << '}';
+	}
+
 	void print(const Operand<Op::typeisobject>& operands) {
 		line() << "type is object %" << operands.lvid;
 	}
@@ -531,6 +555,52 @@ template<class S> struct Printer final {
 		line() << "memchecker.hold %" << operands.lvid << ", size: %" << operands.size;
 	}
 
+	template<class T> void printOperatorImm(const T& operands, const AnyString& opname) {
+		line() << '%' << operands.lvid << " = %" << operands.lhs << ' ' << opname << ' ' << operands.value;
+	}
+
+	void print(const Operand<Op::addimm>& operands) {
+		printOperatorImm(operands, "addimm");
+	}
+
+	void print(const Operand<Op::subimm>& operands) {
+		printOperatorImm(operands, "subimm");
+	}
+
+	template<class T> void printJumpCompare(const T& operands, const AnyString& opname) {
+		line() << "jz %" << operands.lhs << ' ' << opname << " %" << operands.rhs;
+		out << ", goto lbl " << operands.label;
+	}
+
+	void print(const Operand<Op::jzeq>& operands) {
+		printJumpCompare(operands, "eq");
+	}
+
+	void print(const Operand<Op::jzneq>& operands) {
+		printJumpCompare(operands, "neq");
+	}
+
+	void print(const Operand<Op::jzlt>& operands) {
+		printJumpCompare(operands, "lt");
+	}
+
+	void print(const Operand<Op::jzilt>& operands) {
+		printJumpCompare(operands, "ilt");
+	}
+
+	void print(const Operand<Op::jzlte>& operands) {
+		printJumpCompare(operands, "lte");
+	}
+
+	void print(const Operand<Op::jzilte>& operands) {
+		printJumpCompare(operands, "ilte");
+	}
+
+	void print(const Operand<Op::jzfield>& operands) {
+		line() << "jz fieldget u64 %" << operands.self << '.' << operands.var;
+		out << " == 0, goto lbl " << operands.label;
+	}
+
 	void print(const Operand<Op::opassert>& operands) {
 		line() << "assert %" << operands.lvid << " != 0";
 	}
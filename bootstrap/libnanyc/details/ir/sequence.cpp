@@ -55,9 +55,19 @@ void Sequence::clear() {
 	free(m_body);
 	m_capacity = 0;
 	m_body = nullptr;
+	m_labels.clear();
 	stringrefs.clear();
 }
 
+void Sequence::append(const Instruction* instructions, uint32_t count) {
+	if (count != 0) {
+		if (m_capacity < m_size + count)
+			grow(m_size + count);
+		YUNI_MEMCPY(m_body + m_size, sizeof(Instruction) * (m_capacity - m_size), instructions, count * sizeof(Instruction));
+		m_size += count;
+	}
+}
+
 void Sequence::grow(uint32_t count) {
 	assert(count > 0);
 	uint32_t newCapacity = m_capacity;
@@ -197,6 +207,38 @@ bool Sequence::jumpToLabelBackward(const Instruction*& cursor, uint32_t label) c
 	return false;
 }
 
+bool Sequence::indexLabels() {
+	m_labels.clear();
+	uint32_t upperLabel = 0;
+	for (uint32_t i = 0; i != m_size; ++i) {
+		if (m_body[i].opcodes[0] == static_cast<uint32_t>(ir::isa::Op::label)) {
+			uint32_t label = m_body[i].to<ir::isa::Op::label>().label;
+			if (label > upperLabel)
+				upperLabel = label;
+		}
+	}
+	if (upperLabel == 0)
+		return false; // no label, nothing to index
+	m_labels.resize(upperLabel + 1, 0u);
+	for (uint32_t i = 0; i != m_size; ++i) {
+		if (m_body[i].opcodes[0] == static_cast<uint32_t>(ir::isa::Op::label)) {
+			uint32_t label = m_body[i].to<ir::isa::Op::label>().label;
+			if (unlikely(m_labels[label] != 0)) {
+				// the same label is defined twice, the jumps must be resolved
+				// according to the current position (see jumpToLabelForward/Backward)
+				m_labels.clear();
+				return false;
+			}
+			m_labels[label] = i + 1;
+		}
+	}
+	return true;
+}
+
+void Sequence::clearLabelIndex() {
+	m_labels.clear();
+}
+
 bool Sequence::isCursorValid(const Instruction& instr) const {
 	return (m_size > 0 and m_capacity > 0)
 		and (&instr >= m_body)
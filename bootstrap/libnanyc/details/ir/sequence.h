@@ -7,6 +7,7 @@
 #include "details/utils/stringrefs.h"
 #include "details/utils/clid.h"
 #include <memory>
+#include <vector>
 #include <cassert>
 
 #ifdef alloca
@@ -35,6 +36,8 @@ struct Sequence final {
 	bool jumpToLabelForward(const Instruction*& cursor, uint32_t label) const;
 	//! Go to a previous label
 	bool jumpToLabelBackward(const Instruction*& cursor, uint32_t label) const;
+	//! Go to a label using the label index (see indexLabels())
+	bool jumpToLabel(const Instruction*& cursor, uint32_t label) const;
 
 	//! Move the cursor at the end of the blueprint
 	void moveCursorFromBlueprintToEnd(Instruction*& cursor) const;
@@ -55,6 +58,8 @@ struct Sequence final {
 
 	//! emit a new Instruction
 	template<isa::Op O> isa::Operand<O>& emit();
+	//! Append raw instructions
+	void append(const Instruction* instructions, uint32_t count);
 
 	//! Get the offset of an instruction within the sequence
 	template<isa::Op O> uint32_t offsetOf(const isa::Operand<O>& instr) const;
@@ -83,6 +88,22 @@ struct Sequence final {
 	void increaseAllLVID(uint32_t inc, uint32_t greaterThan, uint32_t offset = 0);
 	//@}
 
+	//! \name Labels
+	//@{
+	/*!
+	** \brief Build the label index (label id -> offset) for direct jumps
+	**
+	** This method should be called once the sequence is finalized (after instanciation).
+	** Any further modification of the sequence invalidates the index.
+	** \return True if the index is usable (labels are unique within the sequence)
+	*/
+	bool indexLabels();
+	//! Get if the labels are indexed
+	bool hasLabelIndex() const;
+	//! Drop the label index
+	void clearLabelIndex();
+	//@}
+
 	//! \name Memory Management
 	//@{
 	//! Get how many instructions the sequence has
@@ -94,6 +115,8 @@ struct Sequence final {
 	void clear();
 	//! Reserve enough memory for N instructions
 	void reserve(uint32_t count);
+	//! Keep only the N first instructions (the label index is dropped)
+	void truncate(uint32_t count);
 	//@}
 
 	//! \name Debug
@@ -122,6 +145,8 @@ private:
 	uint32_t m_capacity = 0u;
 	//! m_body of the sequence
 	Instruction* m_body = nullptr;
+	//! Label index: label id -> offset + 1 (0 if the label does not exist)
+	std::vector<uint32_t> m_labels;
 
 }; // Sequence
 
@@ -13,6 +13,12 @@ inline void Sequence::reserve(uint32_t count) {
 		grow(count);
 }
 
+inline void Sequence::truncate(uint32_t count) {
+	assert(count <= m_size);
+	m_size = count;
+	m_labels.clear();
+}
+
 inline uint32_t Sequence::opcodeCount() const {
 	return m_size;
 }
@@ -31,6 +37,22 @@ inline Instruction& Sequence::at(uint32_t offset) {
 	return m_body[offset];
 }
 
+inline bool Sequence::hasLabelIndex() const {
+	return not m_labels.empty();
+}
+
+inline bool Sequence::jumpToLabel(const Instruction*& cursor, uint32_t label) const {
+	assert(hasLabelIndex());
+	if (likely(label < m_labels.size())) {
+		uint32_t offset = m_labels[label];
+		if (likely(offset != 0)) {
+			cursor = m_body + (offset - 1);
+			return true;
+		}
+	}
+	return false;
+}
+
 template<isa::Op O> inline isa::Operand<O>& Sequence::at(uint32_t offset) {
 	assert(offset < m_size);
 	static_assert(sizeof(Instruction) >= sizeof(isa::Operand<O>), "m_size mismatch");
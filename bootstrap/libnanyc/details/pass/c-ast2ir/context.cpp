@@ -23,16 +23,7 @@ void Context::retriveReportMetadata(void* self, Logs::Level, const AST::Node* no
 	auto& ctx = *(reinterpret_cast<Context*>(self));
 	filename = ctx.dbgSourceFilename;
 	if (node and node->offset > 0) {
-		auto it = ctx.offsetToLine.lower_bound(node->offset);
-		if (it != ctx.offsetToLine.end()) {
-			if (it->first == node->offset or (--it != ctx.offsetToLine.end())) {
-				line = it->second;
-				offset = node->offset - it->first;
-				return;
-			}
-		}
-		line = 1;
-		offset = 1;
+		ctx.findPosition(node->offset, line, offset);
 	}
 	else {
 		line = 0;
@@ -50,12 +41,13 @@ void Context::useNamespace(const AnyString& nmspc) {
 }
 
 void Context::generateLineIndexes(const AnyString& content) {
-	uint32_t line = 1;
 	const char* base = content.c_str();
 	const char* end  = base + content.size();
+	lineFeeds.clear();
+	lineFeeds.reserve(static_cast<size_t>(std::count(base, end, '\n')));
 	for (const char* c = base; c != end; ++c) {
 		if (*c == '\n')
-			offsetToLine.emplace(static_cast<uint32_t>(c - base), ++line);
+			lineFeeds.push_back(static_cast<uint32_t>(c - base));
 	}
 }
 
@@ -5,7 +5,7 @@
 #include "details/grammar/nany.h"
 #include "details/errors/errors.h"
 #include "details/pass/c-ast2ir/reuse.h"
-#include <map>
+#include <vector>
 #include <cassert>
 
 namespace ny::ir::Producer {
@@ -27,6 +27,8 @@ struct Context final {
 
 	//! Generate a mapping between input offsets and line numbers
 	void generateLineIndexes(const AnyString& content);
+	//! Find the line (1-based) and the column (1-based) of an input offset (0-based - bytes)
+	void findPosition(uint32_t offset, uint32_t& line, uint32_t& column) const;
 
 	void invalidateLastDebugLine();
 
@@ -40,14 +42,17 @@ public:
 	//! Has debug info ?
 	bool debuginfo = true;
 
-	//! Map contet offset (0-based - bytes) -> lines (1-based, from source input)
-	std::map<uint32_t, uint32_t> offsetToLine;
+	//! Offsets (0-based - bytes) of all line feeds from source input, sorted (see findPosition())
+	std::vector<uint32_t> lineFeeds;
 
 	Reuse reuse;
 
 	//! Debug current source filename
 	AnyString dbgSourceFilename;
 
+	//! Func call (AST node) to make asynchronous (operator '&'), if any
+	const AST::Node* asyncCall = nullptr;
+
 	struct final {
 		void* userdata = nullptr;
 		void (*on_unittest)(void* userdata, const char* mod, uint32_t mlen, const char* name, uint32_t nlen) = nullptr;
@@ -1,5 +1,6 @@
 #pragma once
 #include "context.h"
+#include <algorithm>
 
 namespace ny::ir::Producer {
 
@@ -7,4 +8,12 @@ inline void Context::invalidateLastDebugLine() {
 	m_previousDbgLine = (uint32_t) - 1; // forcing debug infos
 }
 
+inline void Context::findPosition(uint32_t offset, uint32_t& line, uint32_t& column) const {
+	// the line feeds before the offset
+	auto it = std::lower_bound(lineFeeds.begin(), lineFeeds.end(), offset);
+	uint32_t count = static_cast<uint32_t>(it - lineFeeds.begin());
+	line = count + 1;
+	column = (count != 0) ? (offset - lineFeeds[count - 1]) : (offset + 1);
+}
+
 } // namespace ny::ir::Producer
@@ -15,19 +15,21 @@ bool isShortcircuit(AST::Node& node, AST::Node* parent) {
 		and (parent->text == "^and" or parent->text == "^or");
 }
 
-bool emitFunCallNoParameter(Scope& scope, uint32_t functor, uint32_t& localvar) {
+bool emitFunCallNoParameter(Scope& scope, uint32_t functor, uint32_t& localvar, bool async) {
 	auto& irout = scope.ircode();
 	auto callret = ir::emit::alloc(irout, scope.nextvar());
 	localvar = callret; // the new expression value
 	// no pushed parameter - direct call - no need for scopes or something else
 	// ... but template parameters if any
 	scope.emitTmplParametersIfAny();
+	if (async)
+		ir::emit::async(irout, callret);
 	ir::emit::call(irout, callret, functor);
 	ir::emit::jzraise(irout, scope.nextvar());
 	return true;
 }
 
-bool emitFuncCallWithParameters(Scope& scope, uint32_t functor, uint32_t& localvar, AST::Node& node) {
+bool emitFuncCallWithParameters(Scope& scope, uint32_t functor, uint32_t& localvar, AST::Node& node, bool async) {
 	auto& irout = scope.ircode();
 	auto callret = ir::emit::alloc(irout, scope.nextvar());
 	localvar = callret; // the new expression value
@@ -37,6 +39,8 @@ bool emitFuncCallWithParameters(Scope& scope, uint32_t functor, uint32_t& localv
 		success = scope.visitASTExprCallParameters(node);
 		scope.emitTmplParametersIfAny();
 		scope.emitDebugpos(node);
+		if (async)
+			ir::emit::async(irout, callret);
 		ir::emit::call(irout, callret, functor);
 	}
 	// 'jzraise' after the scope since parameters must always be unref
@@ -193,16 +197,39 @@ bool Scope::visitASTExprCall(AST::Node* node, uint32_t& localvar, AST::Node* par
 	// ask to resolve the call to operator ()
 	auto functor = ir::emit::alloc(irout, nextvar());
 	ir::emit::identify(irout, functor, "^()", localvar);
+	bool async = (node and node == context.asyncCall);
+	if (async)
+		context.asyncCall = nullptr; // consumed, the parameters may have their own
 	bool hasParameters = node and not node->children.empty();
 	if (not hasParameters)
-		return emitFunCallNoParameter(*this, functor, localvar);
+		return emitFunCallNoParameter(*this, functor, localvar, async);
 	// short-circuit only applies to func call with 2 parameters
 	// but the code for minimal evaluation can not be determined yet (some
 	// member may have to be read, or maybe it should not be done at all)
 	// this flag will only prepare some room for additional opcodes if required
-	return not isShortcircuit(*node, parent)
-		? emitFuncCallWithParameters(*this, functor, localvar, *node)
-		: emitShortCircuitFuncCall(*this, functor, localvar, *node);
+	if (not isShortcircuit(*node, parent))
+		return emitFuncCallWithParameters(*this, functor, localvar, *node, async);
+	if (unlikely(async))
+		return (error(*node) << "asynchronous call not allowed for operators 'and' and 'or'");
+	return emitShortCircuitFuncCall(*this, functor, localvar, *node);
+}
+
+bool Scope::visitASTExprAsync(AST::Node& node, uint32_t& localvar) {
+	assert(node.rule == AST::rgExprAsync);
+	// the func call to make asynchronous is the last one of the expression (ex: `& a.foo(42)`)
+	const AST::Node* call = &node;
+	while (call->rule != AST::rgCall and not call->children.empty())
+		call = &call->children.back();
+	if (unlikely(call->rule != AST::rgCall))
+		return (error(node) << "function call expected after '&'");
+	auto* previous = context.asyncCall;
+	context.asyncCall = call;
+	bool success = visitASTExprContinuation(node, localvar);
+	bool emitted = (context.asyncCall != call);
+	context.asyncCall = previous;
+	if (unlikely(success and not emitted))
+		return (error(node) << "function call expected after '&'");
+	return success;
 }
 
 } // namespace ny::ir::Producer
@@ -80,6 +80,9 @@ bool Scope::visitASTExprContinuation(AST::Node& node, uint32_t& localvar, bool a
 			case AST::rgCall:
 				success &= visitASTExprCall(&child, localvar, &node);
 				break;
+			case AST::rgExprAsync:
+				success &= visitASTExprAsync(child, localvar);
+				break;
 			case AST::rgNumber:
 				success &= visitASTExprNumber(child, localvar);
 				break;
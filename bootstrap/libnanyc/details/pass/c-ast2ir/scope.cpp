@@ -8,14 +8,9 @@ namespace ny::ir::Producer {
 
 void Scope::emitDebugpos(AST::Node& node) {
 	if (node.offset > 0) {
-		auto it = context.offsetToLine.lower_bound(node.offset);
-		if (it != context.offsetToLine.end()) {
-			bool emit = (it->first == node.offset);
-			if (not emit and context.offsetToLine.begin() != it)
-				emit = (--it != context.offsetToLine.end());
-			if (emit)
-				addDebugCurrentPosition(it->second, node.offset - it->first);
-		}
+		uint32_t line, column;
+		context.findPosition(node.offset, line, column);
+		addDebugCurrentPosition(line, column);
 	}
 }
 
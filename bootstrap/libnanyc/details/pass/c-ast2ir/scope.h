@@ -82,6 +82,7 @@ public:
 	bool visitASTClass(AST::Node&, uint32_t* localvar = nullptr);
 	bool visitASTDeclGenericTypeParameters(AST::Node&);
 	bool visitASTExpr(AST::Node&, uint32_t& localvar, bool allowScope = false);
+	bool visitASTExprAsync(AST::Node&, uint32_t& localvar); // async func call
 	bool visitASTExprCall(AST::Node*, uint32_t& localvar, AST::Node* parent = nullptr); // func call
 	bool visitASTExprCallParameters(AST::Node&, ShortcircuitUpdate* shortcircuit = nullptr); // parameters of a func call
 	bool visitASTExprChar(AST::Node&, uint32_t& localvar);
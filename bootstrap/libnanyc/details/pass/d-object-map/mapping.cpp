@@ -634,6 +634,7 @@ struct OpcodeReader final {
 			case ir::isa::Op::allocate:
 			case ir::isa::Op::comment:
 			case ir::isa::Op::ensureresolved:
+			case ir::isa::Op::async:
 			case ir::isa::Op::classdefsizeof:
 			case ir::isa::Op::namealias:
 			case ir::isa::Op::store:
@@ -0,0 +1,148 @@
+#include "await.h"
+#include <algorithm>
+#include <vector>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+//! Get if an opcode may change the control flow (or be the target of a jump)
+bool isControlFlow(uint32_t opcode) {
+	switch (static_cast<Op>(opcode)) {
+		case Op::label:
+		case Op::jmp:
+		case Op::jz:
+		case Op::jnz:
+		case Op::jzraise:
+		case Op::jmperrhandler:
+		case Op::onscopefail:
+		case Op::ret:
+		case Op::raise:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//! Get if an instruction may use a register (conservative, see passPeepholeIR())
+bool references(const ir::Instruction& instr, uint32_t lvid) {
+	if (instr.opcodes[0] == static_cast<uint32_t>(Op::storeConstant))
+		return instr.opcodes[1] == lvid;
+	return instr.opcodes[1] == lvid or instr.opcodes[2] == lvid or instr.opcodes[3] == lvid;
+}
+
+struct Pending final {
+	//! Register holding the job, then its result
+	uint32_t lvid;
+	//! Registers receiving a copy of the result, delayed after the 'await'
+	std::vector<uint32_t> copies;
+};
+
+struct AwaitInserter final {
+	bool references(const ir::Instruction& instr, const Pending& job) const {
+		if (ny::compiler::references(instr, job.lvid))
+			return true;
+		for (auto lvid: job.copies) {
+			if (ny::compiler::references(instr, lvid))
+				return true;
+		}
+		return false;
+	}
+
+	void flush(const Pending& job) {
+		auto& awaitop = emit(Op::await).to<Op::await>();
+		awaitop.lvid = job.lvid;
+		for (auto lvid: job.copies) {
+			auto& store = emit(Op::store).to<Op::store>();
+			store.lvid = lvid;
+			store.source = job.lvid;
+		}
+	}
+
+	//! Wait for all jobs used by the given instruction
+	void flushIfReferenced(const ir::Instruction& instr) {
+		uint32_t size = 0;
+		for (uint32_t i = 0; i != static_cast<uint32_t>(pending.size()); ++i) {
+			if (references(instr, pending[i]))
+				flush(pending[i]);
+			else if (size++ != i)
+				pending[size - 1] = std::move(pending[i]);
+		}
+		pending.resize(size);
+	}
+
+	void flushAll() {
+		for (auto& job: pending)
+			flush(job);
+		pending.clear();
+	}
+
+	ir::Instruction& emit(Op opcode) {
+		out.emplace_back();
+		auto& instr = out.back();
+		instr.opcodes[0] = static_cast<uint32_t>(opcode);
+		instr.opcodes[1] = instr.opcodes[2] = instr.opcodes[3] = 0;
+		return instr;
+	}
+
+	void process(const ir::Instruction& instr) {
+		uint32_t opcode = instr.opcodes[0];
+		if (not pending.empty()) {
+			if (isControlFlow(opcode))
+				flushAll();
+			else if (opcode == static_cast<uint32_t>(Op::store) and delayCopy(instr.to<Op::store>()))
+				return;
+			else if (opcode != static_cast<uint32_t>(Op::spawn)) // parameters already pushed
+				flushIfReferenced(instr);
+		}
+		out.push_back(instr);
+		if (opcode == static_cast<uint32_t>(Op::spawn))
+			pending.push_back(Pending{instr.opcodes[1], {}});
+	}
+
+	//! Try to delay `store %dst = %job` after the 'await' of the job
+	bool delayCopy(const ir::isa::Operand<Op::store>& store) {
+		auto isjob = [&](const Pending& job) { return job.lvid == store.source; };
+		if (store.lvid == store.source or std::none_of(pending.begin(), pending.end(), isjob))
+			return false;
+		// the destination may be used by another pending job
+		uint32_t size = 0;
+		for (uint32_t i = 0; i != static_cast<uint32_t>(pending.size()); ++i) {
+			auto& job = pending[i];
+			bool used = not isjob(job)
+				and (job.lvid == store.lvid or std::count(job.copies.begin(), job.copies.end(), store.lvid) != 0);
+			if (used)
+				flush(job);
+			else if (size++ != i)
+				pending[size - 1] = std::move(job);
+		}
+		pending.resize(size);
+		std::find_if(pending.begin(), pending.end(), isjob)->copies.push_back(store.lvid);
+		return true;
+	}
+
+	std::vector<ir::Instruction> out;
+	std::vector<Pending> pending;
+};
+
+} // namespace
+
+void passAwaitIR(ir::Sequence& sequence) {
+	uint32_t count = sequence.opcodeCount();
+	uint32_t first = 1; // stacksize
+	while (first < count and sequence.at(first).opcodes[0] != static_cast<uint32_t>(Op::spawn))
+		++first;
+	if (first >= count)
+		return; // no asynchronous func call, nothing to do
+	AwaitInserter inserter;
+	inserter.out.reserve(count - first + 8);
+	for (uint32_t i = first; i != count; ++i)
+		inserter.process(sequence.at(i));
+	inserter.flushAll();
+	sequence.truncate(first);
+	sequence.append(inserter.out.data(), static_cast<uint32_t>(inserter.out.size()));
+}
+
+} // ny::compiler
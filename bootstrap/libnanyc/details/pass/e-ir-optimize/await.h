@@ -0,0 +1,16 @@
+#pragma once
+#include "details/ir/sequence.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Insert an 'await' for each asynchronous func call of an instanciated function
+**
+** The 'await' is inserted as late as possible: just before the first instruction
+** using the result (or a copy of it) or before any change in the control flow
+** (label, jump, return...). Plain copies of the result are delayed after the
+** 'await'. Must be called before the peephole pass, the label index is dropped.
+*/
+void passAwaitIR(ir::Sequence&);
+
+} // ny::compiler
@@ -0,0 +1,320 @@
+#include "escape.h"
+#include "registers.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+void nop(ir::Instruction& instr) {
+	instr.opcodes[0] = static_cast<uint32_t>(Op::nop);
+}
+
+struct ScalarReplacement final {
+	ScalarReplacement(ir::Sequence& sequence, AtomMap& map)
+		: sequence(sequence)
+		, map(map)
+		, count(sequence.opcodeCount())
+		, framesize(sequence.at<Op::stacksize>(0).add) {
+	}
+
+	//! Index all labels and backward jumps (false if a label is defined twice)
+	bool indexControlFlow() {
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			if (instr.opcodes[0] == static_cast<uint32_t>(Op::label)) {
+				uint32_t label = instr.to<Op::label>().label;
+				if (labels.size() <= label)
+					labels.resize(label + 1, 0u);
+				if (labels[label] != 0)
+					return false;
+				labels[label] = i;
+			}
+		}
+		for (uint32_t i = 1; i != count; ++i) {
+			uint32_t label = jumpTarget(sequence.at(i));
+			if (label != 0 and label < labels.size() and labels[label] != 0 and labels[label] < i)
+				loops.emplace_back(labels[label], i);
+		}
+		return true;
+	}
+
+	//! Get if an instruction may be executed again once the given one has been executed
+	bool inLoop(uint32_t offset) const {
+		return std::any_of(loops.begin(), loops.end(), [&](auto& loop) {
+			return loop.first <= offset and offset < loop.second;
+		});
+	}
+
+	bool isMember(uint32_t lvid) const {
+		return lvid < group.size() and group[lvid] != 0;
+	}
+
+	//! Get if the object can be released without calling any code
+	bool isTrivialDtor(uint32_t atomid) const {
+		auto atom = map.findAtom(atomid);
+		if (!atom or atomid == 0 or atom->instances.size() == 0)
+			return false;
+		auto* ircode = atom->instances[0].ircodeIfExists(); // always only one version of the dtor
+		if (ircode == nullptr or atom->instances[0].symbolname().empty())
+			return false;
+		uint32_t dcount = ircode->opcodeCount();
+		for (uint32_t i = 1; i < dcount; ++i) {
+			switch (static_cast<Op>(ircode->at(i).opcodes[0])) {
+				case Op::nop:
+				case Op::comment:
+				case Op::scope:
+				case Op::end:
+				case Op::stackalloc:
+				case Op::ret:
+					break;
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	//! Add all copies of the object to the group (until no new register is found)
+	void collectCopies() {
+		bool changed;
+		do {
+			changed = false;
+			for (uint32_t i = 1; i != count; ++i) {
+				auto& instr = sequence.at(i);
+				if (instr.opcodes[0] != static_cast<uint32_t>(Op::store))
+					continue;
+				auto& store = instr.to<Op::store>();
+				if (isMember(store.source) and not isMember(store.lvid) and store.lvid < group.size()) {
+					group[store.lvid] = 1;
+					changed = true;
+				}
+			}
+		}
+		while (changed);
+	}
+
+	/*!
+	** \brief Get if all uses of the object allocated at the given offset can be replaced
+	**
+	** An object allocated in a loop must only be used after its allocation,
+	** without any label in between (the variable members of an object from a
+	** previous iteration can not be observed).
+	*/
+	bool isLocal(uint32_t def) {
+		uint32_t firstUse = (uint32_t) -1;
+		uint32_t lastUse = 0;
+		auto use = [&](uint32_t offset) {
+			firstUse = std::min(firstUse, offset);
+			lastUse = std::max(lastUse, offset);
+		};
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::memalloc: {
+					auto& alloc = instr.to<Op::memalloc>();
+					if (i != def and (isMember(alloc.lvid) or isMember(alloc.regsize)))
+						return false;
+					continue;
+				}
+				case Op::store: {
+					auto& store = instr.to<Op::store>();
+					if (isMember(store.lvid)) {
+						if (not isMember(store.source))
+							return false; // the copy is not only a copy of the object
+						use(i);
+					}
+					continue;
+				}
+				case Op::ref: {
+					if (isMember(instr.to<Op::ref>().lvid))
+						use(i);
+					continue;
+				}
+				case Op::unref: {
+					auto& unref = instr.to<Op::unref>();
+					if (isMember(unref.lvid)) {
+						if (not isTrivialDtor(unref.atomid))
+							return false;
+						use(i);
+					}
+					continue;
+				}
+				case Op::fieldget:
+				case Op::fieldset: {
+					auto& field = instr.to<Op::fieldget>(); // same layout
+					if (isMember(field.lvid))
+						return false; // overwritten or stored into another object
+					if (isMember(field.self))
+						use(i);
+					continue;
+				}
+				case Op::jzfield: {
+					if (isMember(instr.to<Op::jzfield>().self))
+						use(i);
+					continue;
+				}
+				default: {
+					bool escapes = false;
+					eachRegister(instr, [&](uint32_t lvid) { escapes |= isMember(lvid); });
+					if (escapes)
+						return false;
+					continue;
+				}
+			}
+		}
+		if (not inLoop(def))
+			return true;
+		if (firstUse < def)
+			return false;
+		for (uint32_t i = def + 1; i < lastUse; ++i) {
+			if (sequence.at(i).opcodes[0] == static_cast<uint32_t>(Op::label))
+				return false;
+		}
+		return true;
+	}
+
+	//! Get the register holding a variable member of the object
+	uint32_t field(uint32_t var) {
+		for (auto& pair: fields) {
+			if (pair.first == var)
+				return pair.second;
+		}
+		fields.emplace_back(var, framesize++);
+		return fields.back().second;
+	}
+
+	//! Replace all uses of the object by registers
+	void replace(uint32_t def) {
+		fields.clear();
+		uint32_t regsize = sequence.at<Op::memalloc>(def).regsize;
+		nop(sequence.at(def));
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::store: {
+					if (isMember(instr.to<Op::store>().lvid))
+						nop(instr);
+					break;
+				}
+				case Op::ref:
+				case Op::unref: {
+					if (isMember(instr.opcodes[1]))
+						nop(instr);
+					break;
+				}
+				case Op::fieldget: {
+					auto& operands = instr.to<Op::fieldget>();
+					if (isMember(operands.self)) {
+						uint32_t lvid = operands.lvid;
+						uint32_t source = field(operands.var);
+						auto& copy = instr.to<Op::store>();
+						copy.opcode = static_cast<uint32_t>(Op::store);
+						copy.lvid = lvid;
+						copy.source = source;
+					}
+					break;
+				}
+				case Op::fieldset: {
+					auto& operands = instr.to<Op::fieldset>();
+					if (isMember(operands.self)) {
+						uint32_t source = operands.lvid;
+						uint32_t lvid = field(operands.var);
+						auto& copy = instr.to<Op::store>();
+						copy.opcode = static_cast<uint32_t>(Op::store);
+						copy.lvid = lvid;
+						copy.source = source;
+					}
+					break;
+				}
+				case Op::jzfield: {
+					auto& operands = instr.to<Op::jzfield>();
+					if (isMember(operands.self)) {
+						uint32_t lvid = field(operands.var);
+						uint32_t label = operands.label;
+						auto& jz = instr.to<Op::jz>();
+						jz.opcode = static_cast<uint32_t>(Op::jz);
+						jz.lvid = lvid;
+						jz.result = 0; // %0 is only used as a sink
+						jz.label = label;
+					}
+					break;
+				}
+				default:
+					break;
+			}
+		}
+		removeSizeof(regsize);
+	}
+
+	//! Remove the computation of the size of the object, if not used by anything else
+	void removeSizeof(uint32_t regsize) {
+		uint32_t definition = 0;
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			bool used = false;
+			eachRegister(instr, [&](uint32_t lvid) { used |= (lvid == regsize); });
+			if (not used)
+				continue;
+			if (definition != 0 or instr.opcodes[0] != static_cast<uint32_t>(Op::classdefsizeof))
+				return;
+			definition = i;
+		}
+		if (definition != 0)
+			nop(sequence.at(definition));
+	}
+
+	bool run() {
+		if (not indexControlFlow())
+			return false;
+		uint32_t replaced = 0;
+		for (uint32_t i = 1; i != count; ++i) {
+			if (sequence.at(i).opcodes[0] != static_cast<uint32_t>(Op::memalloc))
+				continue;
+			uint32_t lvid = sequence.at<Op::memalloc>(i).lvid;
+			if (lvid == 0 or not (lvid < framesize))
+				continue;
+			group.assign(framesize, 0);
+			group[lvid] = 1;
+			collectCopies();
+			if (isLocal(i)) {
+				replace(i);
+				++replaced;
+			}
+		}
+		if (replaced == 0)
+			return false;
+		sequence.at<Op::stacksize>(0).add = framesize;
+		return true;
+	}
+
+	ir::Sequence& sequence;
+	AtomMap& map;
+	const uint32_t count;
+	//! Number of registers, including the new ones for the variable members
+	uint32_t framesize;
+	//! Label id -> offset (0 if not defined)
+	std::vector<uint32_t> labels;
+	//! All backward jumps {offset of the label, offset of the jump}
+	std::vector<std::pair<uint32_t, uint32_t>> loops;
+	//! Registers holding the object being analyzed (1 if member)
+	std::vector<uint8_t> group;
+	//! Variable members of the object being replaced {field index, register}
+	std::vector<std::pair<uint32_t, uint32_t>> fields;
+};
+
+} // namespace
+
+void passEscapeAnalysisIR(ir::Sequence& sequence, AtomMap& map) {
+	if (unlikely(sequence.opcodeCount() == 0
+		or sequence.at(0).opcodes[0] != static_cast<uint32_t>(Op::stacksize)))
+		return;
+	ScalarReplacement pass{sequence, map};
+	pass.run();
+}
+
+} // ny::compiler
@@ -0,0 +1,21 @@
+#pragma once
+#include "details/ir/sequence.h"
+#include "details/atom/atom-map.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Scalar replacement of the objects not escaping an instanciated function
+**
+** An object allocated by the function (`memalloc`) does not escape if it is
+** only used to read or write its variable members, to be acquired or released
+** (with a trivial dtor) or copied into other registers following the same rules.
+** Each variable member of such object is stored into a new register, and the
+** allocation and all `ref`/`unref` are removed. Mostly useful once the ctor and
+** the operators of builtin wrappers (u32, bool...) have been inlined.
+**
+** Must be called before the peephole pass (the removed opcodes become `nop`).
+*/
+void passEscapeAnalysisIR(ir::Sequence&, AtomMap&);
+
+} // ny::compiler
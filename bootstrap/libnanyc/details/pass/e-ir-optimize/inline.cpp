@@ -0,0 +1,281 @@
+#include "inline.h"
+#include "registers.h"
+#include "details/errors/errors.h"
+#include "libnanyc-config.h"
+#include "libnanyc-traces.h"
+#include <algorithm>
+#include <vector>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+//! Renumbering of the registers, labels and strings of the callee
+struct Relocation final {
+	//! Renumber all registers and labels of an instruction (false if the opcode can not be inlined)
+	bool operator () (ir::Instruction& instr) const {
+		auto& operands = instr.opcodes;
+		switch (static_cast<Op>(operands[0])) {
+			case Op::raise:
+			case Op::jmperrhandler:
+			case Op::spawn:
+			case Op::await:
+			case Op::ret:
+			case Op::comment: // already removed by the peephole pass
+				return false; // raise, error handlers, asynchronous calls...
+			case Op::storeText: {
+				auto& text = instr.to<Op::storeText>();
+				text.text = to.ref(from[text.text]);
+				break;
+			}
+			case Op::intrinsic: {
+				auto& intrinsic = instr.to<Op::intrinsic>();
+				intrinsic.intrinsic = to.ref(from[intrinsic.intrinsic]);
+				break;
+			}
+			case Op::push: {
+				auto& push = instr.to<Op::push>();
+				if (push.name != 0)
+					push.name = to.ref(from[push.name]);
+				break;
+			}
+			case Op::label:
+			case Op::jmp:
+			case Op::jzraise: {
+				operands[1] += labels;
+				break;
+			}
+			case Op::jz:
+			case Op::jnz:
+			case Op::jzeq:
+			case Op::jzneq:
+			case Op::jzlt:
+			case Op::jzilt:
+			case Op::jzlte:
+			case Op::jzilte:
+			case Op::jzfield: {
+				operands[3] += labels;
+				break;
+			}
+			default:
+				break;
+		}
+		return eachRegisterOperand(instr, [&](uint32_t& lvid) { reg(lvid); });
+	}
+
+	//! Renumber a register (%0 is only used as a sink and is shared)
+	void reg(uint32_t& lvid) const {
+		if (lvid != 0)
+			lvid += registers;
+	}
+
+	//! Offset for all registers of the callee
+	uint32_t registers;
+	//! Offset for all labels of the callee
+	uint32_t labels;
+	//! Strings of the callee
+	const StringRefs& from;
+	//! Strings of the caller
+	StringRefs& to;
+};
+
+//! Get the highest label of a sequence (0 if none, -1 if a label is defined twice)
+uint32_t upperLabel(const ir::Sequence& sequence, std::vector<uint32_t>& labels) {
+	labels.clear();
+	uint32_t count = sequence.opcodeCount();
+	for (uint32_t i = 1; i < count; ++i) {
+		auto& instr = sequence.at(i);
+		if (instr.opcodes[0] == static_cast<uint32_t>(Op::label))
+			labels.push_back(instr.to<Op::label>().label);
+	}
+	if (labels.empty())
+		return 0;
+	std::sort(labels.begin(), labels.end());
+	if (std::adjacent_find(labels.begin(), labels.end()) != labels.end())
+		return (uint32_t) -1;
+	return labels.back();
+}
+
+struct Inliner final {
+	Inliner(ir::Sequence& sequence, AtomMap& map)
+		: sequence(sequence)
+		, map(map)
+		, framesize(sequence.at<Op::stacksize>(0).add) {
+	}
+
+	//! Get the IR code of the called function, if it can be inlined
+	const ir::Sequence* callee(const ir::isa::Operand<Op::call>& call) const {
+		if (call.instanceid == (uint32_t) -1)
+			return nullptr;
+		auto atom = map.findAtom(call.ptr2func);
+		if (!atom or not atom->isFunction())
+			return nullptr;
+		// not completely instanciated yet or calling itself (directly or indirectly)
+		if (atom->flags(Atom::Flags::instanciating) or atom->flags(Atom::Flags::recursive))
+			return nullptr;
+		if (not (call.instanceid < atom->instances.size()))
+			return nullptr;
+		auto instance = atom->instances[call.instanceid];
+		auto* ircode = instance.ircodeIfExists();
+		if (ircode == nullptr or instance.symbolname().empty())
+			return nullptr;
+		uint32_t count = ircode->opcodeCount();
+		if (count < 2 or count > config::maxInlinedFuncSize + 1)
+			return nullptr;
+		if (ircode->at(0).opcodes[0] != static_cast<uint32_t>(Op::stacksize))
+			return nullptr;
+		return ircode;
+	}
+
+	/*!
+	** \brief Try to replace a func call by the IR code of the callee
+	**
+	** \param params Number of parameters, pushed by the last instructions of `out`
+	*/
+	bool expand(const ir::isa::Operand<Op::call>& call, uint32_t params) {
+		auto* ircode = callee(call);
+		if (ircode == nullptr)
+			return false;
+		uint32_t calleeFramesize = ircode->at<Op::stacksize>(0).add;
+		uint32_t count = ircode->opcodeCount();
+		if (2 + params > calleeFramesize // parameters are 2-based
+			or framesize + calleeFramesize > config::maxInlinedFrameSize
+			or out.size() + count + params + 2 > config::maxInliningSequenceSize)
+			return false;
+		uint32_t calleeUpperLabel = upperLabel(*ircode, labels);
+		if (calleeUpperLabel == (uint32_t) -1)
+			return false;
+		Relocation relocate{framesize - 1, nextLabel, ircode->stringrefs, sequence.stringrefs};
+		uint32_t exit = nextLabel + calleeUpperLabel + 1;
+		bool exitUsed = false;
+		body.clear();
+		for (uint32_t i = 1; i != count; ++i) {
+			ir::Instruction instr = ircode->at(i);
+			if (instr.opcodes[0] == static_cast<uint32_t>(Op::ret)) {
+				auto& result = emit(body, Op::store).to<Op::store>();
+				result.lvid = call.lvid;
+				result.source = instr.to<Op::ret>().lvid;
+				relocate.reg(result.source);
+				if (i + 1 != count) {
+					emit(body, Op::jmp).to<Op::jmp>().label = exit;
+					exitUsed = true;
+				}
+				continue;
+			}
+			if (not relocate(instr))
+				return false;
+			body.push_back(instr);
+		}
+		if (ircode->at(count - 1).opcodes[0] != static_cast<uint32_t>(Op::ret)) {
+			auto& result = emit(body, Op::storeConstant).to<Op::storeConstant>();
+			result.lvid = call.lvid;
+			result.value.u64 = 0;
+		}
+		if (exitUsed)
+			emit(body, Op::label).to<Op::label>().label = exit;
+		// the pushed parameters become plain copies to the registers of the callee
+		uint32_t first = static_cast<uint32_t>(out.size()) - params;
+		for (uint32_t p = 0; p != params; ++p) {
+			auto& copy = out[first + p].to<Op::store>();
+			uint32_t lvid = out[first + p].to<Op::push>().lvid;
+			copy.opcode = static_cast<uint32_t>(Op::store);
+			copy.lvid = framesize + 1 + p;
+			copy.source = lvid;
+		}
+		out.insert(out.end(), body.begin(), body.end());
+		if (config::traces::inlining) {
+			trace() << "inline '" << map.symbolname(call.ptr2func, call.instanceid) << "' ("
+				<< (count - 1) << " opcodes, " << calleeFramesize << " registers) into '" << caller << '\'';
+		}
+		framesize += calleeFramesize - 1;
+		nextLabel = exit + 1;
+		return true;
+	}
+
+	static ir::Instruction& emit(std::vector<ir::Instruction>& target, Op opcode) {
+		target.emplace_back();
+		auto& instr = target.back();
+		instr.opcodes[0] = static_cast<uint32_t>(opcode);
+		instr.opcodes[1] = instr.opcodes[2] = instr.opcodes[3] = 0;
+		return instr;
+	}
+
+	bool run() {
+		uint32_t callerUpperLabel = upperLabel(sequence, labels);
+		if (callerUpperLabel == (uint32_t) -1)
+			return false; // the jumps can not be resolved via a label index anyway
+		nextLabel = callerUpperLabel + 1;
+		uint32_t count = sequence.opcodeCount();
+		out.reserve(count + 64);
+		uint32_t inlined = 0;
+		// parameters pushed since the last func call, and how many just before the current instruction
+		uint32_t pending = 0;
+		uint32_t pushed = 0;
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::push: {
+					out.push_back(instr);
+					++pending;
+					++pushed;
+					continue;
+				}
+				case Op::call: {
+					// all pushed parameters must be contiguous, to be replaced by copies
+					if (pending == pushed and expand(instr.to<Op::call>(), pushed)) {
+						++inlined;
+						pending = pushed = 0;
+						continue;
+					}
+					pending = 0;
+					break;
+				}
+				case Op::fcall:
+				case Op::spawn:
+				case Op::intrinsic: {
+					pending = 0;
+					break;
+				}
+				default:
+					break;
+			}
+			out.push_back(instr);
+			pushed = 0;
+		}
+		if (inlined == 0)
+			return false;
+		sequence.at<Op::stacksize>(0).add = framesize;
+		sequence.truncate(1);
+		sequence.append(out.data(), static_cast<uint32_t>(out.size()));
+		return true;
+	}
+
+	ir::Sequence& sequence;
+	AtomMap& map;
+	AnyString caller;
+	//! Number of registers of the caller, including the inlined functions
+	uint32_t framesize;
+	//! Next free label in the caller
+	uint32_t nextLabel = 1;
+	//! The new IR code of the caller
+	std::vector<ir::Instruction> out;
+	//! The IR code of the callee being inlined
+	std::vector<ir::Instruction> body;
+	//! Temporary list of labels
+	std::vector<uint32_t> labels;
+};
+
+} // namespace
+
+void passInlineIR(ir::Sequence& sequence, AtomMap& map, const AnyString& caller) {
+	if (unlikely(sequence.opcodeCount() == 0
+		or sequence.at(0).opcodes[0] != static_cast<uint32_t>(Op::stacksize)))
+		return;
+	Inliner inliner{sequence, map};
+	inliner.caller = caller;
+	inliner.run();
+}
+
+} // ny::compiler
@@ -0,0 +1,23 @@
+#pragma once
+#include "details/ir/sequence.h"
+#include "details/atom/atom-map.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Inline the calls to small functions into an instanciated function
+**
+** Each resolved `call` to a small function, already instanciated and not
+** recursive, is replaced by a copy of its IR code. The registers of the callee
+** are renumbered after those of the caller (the frame grows accordingly) and its
+** labels after those of the caller. The pushed parameters become plain copies and
+** each `ret` a copy of the result followed by a jump after the inlined code.
+** Functions handling errors by themselves (raise, error handlers...) or with
+** asynchronous calls are never inlined.
+**
+** Must be called before the peephole pass, the label index is dropped.
+** \param caller The symbol name of the function (traces only)
+*/
+void passInlineIR(ir::Sequence&, AtomMap&, const AnyString& caller);
+
+} // ny::compiler
@@ -0,0 +1,209 @@
+#include "peephole.h"
+#include <limits>
+#include <vector>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+//! Get if an opcode has no effect at runtime
+bool isNoop(uint32_t opcode) {
+	switch (static_cast<Op>(opcode)) {
+		case Op::nop:
+		case Op::comment:
+		case Op::scope:
+		case Op::end:
+		case Op::stackalloc:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//! Remove all opcodes without any effect at runtime (offset 0 - stacksize - excluded)
+uint32_t stripNoops(ir::Sequence& sequence) {
+	uint32_t count = sequence.opcodeCount();
+	uint32_t size = 1;
+	for (uint32_t i = 1; i != count; ++i) {
+		auto& instr = sequence.at(i);
+		if (not isNoop(instr.opcodes[0])) {
+			if (size != i)
+				sequence.at(size) = instr;
+			++size;
+		}
+	}
+	return size;
+}
+
+/*!
+** \brief Number of references to each register
+**
+** Conservative: each operand is considered as a register, whatever the opcode.
+** A register can not be considered as a temporary value by mistake, the worst
+** case only prevents some fusions.
+*/
+std::vector<uint32_t> countRegisterUses(const ir::Sequence& sequence, uint32_t count, uint32_t framesize) {
+	std::vector<uint32_t> uses(framesize, 0u);
+	auto use = [&](uint32_t lvid) {
+		if (lvid < framesize)
+			++uses[lvid];
+	};
+	for (uint32_t i = 1; i != count; ++i) {
+		auto& instr = sequence.at(i);
+		if (instr.opcodes[0] == static_cast<uint32_t>(Op::storeConstant)) {
+			use(instr.opcodes[1]); // the other words are the value itself
+			continue;
+		}
+		use(instr.opcodes[1]);
+		use(instr.opcodes[2]);
+		use(instr.opcodes[3]);
+		switch (static_cast<Op>(instr.opcodes[0])) {
+			case Op::raise:
+			case Op::jmperrhandler:
+			case Op::onscopefail: {
+				use(instr.opcodes[2] + 1); // the error is stored into the register 'label + 1'
+				break;
+			}
+			default:
+				break;
+		}
+	}
+	return uses;
+}
+
+struct Fusion final {
+	//! Get if a register is only used by the pair of instructions (definition + use)
+	bool isTemporary(uint32_t lvid) const {
+		return lvid != 0 and lvid < uses.size() and uses[lvid] == 2;
+	}
+
+	//! storeConstant %k = K, add/sub %r = %a, %k
+	bool immediate(ir::Instruction& out, const ir::Instruction& first, const ir::Instruction& second) const {
+		if (first.opcodes[0] != static_cast<uint32_t>(Op::storeConstant))
+			return false;
+		auto& cst = first.to<Op::storeConstant>();
+		if (cst.value.u64 > std::numeric_limits<uint32_t>::max() or not isTemporary(cst.lvid))
+			return false;
+		switch (static_cast<Op>(second.opcodes[0])) {
+			case Op::add: {
+				auto& operands = second.to<Op::add>();
+				uint32_t lhs;
+				if (operands.rhs == cst.lvid and operands.lhs != cst.lvid)
+					lhs = operands.lhs;
+				else if (operands.lhs == cst.lvid and operands.rhs != cst.lvid)
+					lhs = operands.rhs;
+				else
+					return false;
+				auto& fused = out.to<Op::addimm>();
+				fused.opcode = static_cast<uint32_t>(Op::addimm);
+				fused.lvid = operands.lvid;
+				fused.lhs = lhs;
+				fused.value = static_cast<uint32_t>(cst.value.u64);
+				return true;
+			}
+			case Op::sub: {
+				auto& operands = second.to<Op::sub>();
+				if (operands.rhs != cst.lvid or operands.lhs == cst.lvid)
+					return false;
+				auto& fused = out.to<Op::subimm>();
+				fused.opcode = static_cast<uint32_t>(Op::subimm);
+				fused.lvid = operands.lvid;
+				fused.lhs = operands.lhs;
+				fused.value = static_cast<uint32_t>(cst.value.u64);
+				return true;
+			}
+			default:
+				return false;
+		}
+	}
+
+	//! lt %c = %a, %b, jz %c
+	bool compareAndBranch(ir::Instruction& out, const ir::Instruction& first, const ir::Instruction& second) const {
+		if (second.opcodes[0] != static_cast<uint32_t>(Op::jz))
+			return false;
+		auto& jz = second.to<Op::jz>();
+		// %0 is only used as a sink, writing 0 into it when jumping can be dropped
+		if (jz.result != 0 or not isTemporary(jz.lvid))
+			return false;
+		// all comparison operators share the same layout
+		auto& cmp = first.to<Op::lt>();
+		if (cmp.lvid != jz.lvid)
+			return false;
+		Op opcode;
+		bool swap = false;
+		switch (static_cast<Op>(first.opcodes[0])) {
+			case Op::eq:   opcode = Op::jzeq; break;
+			case Op::neq:  opcode = Op::jzneq; break;
+			case Op::lt:   opcode = Op::jzlt; break;
+			case Op::ilt:  opcode = Op::jzilt; break;
+			case Op::lte:  opcode = Op::jzlte; break;
+			case Op::ilte: opcode = Op::jzilte; break;
+			case Op::gt:   opcode = Op::jzlt; swap = true; break;
+			case Op::igt:  opcode = Op::jzilt; swap = true; break;
+			case Op::gte:  opcode = Op::jzlte; swap = true; break;
+			case Op::igte: opcode = Op::jzilte; swap = true; break;
+			default:
+				return false;
+		}
+		auto& fused = out.to<Op::jzlt>();
+		fused.opcode = static_cast<uint32_t>(opcode);
+		fused.lhs = swap ? cmp.rhs : cmp.lhs;
+		fused.rhs = swap ? cmp.lhs : cmp.rhs;
+		fused.label = jz.label;
+		return true;
+	}
+
+	//! fieldget %c = %self.var, jz %c
+	bool fieldAndBranch(ir::Instruction& out, const ir::Instruction& first, const ir::Instruction& second) const {
+		if (first.opcodes[0] != static_cast<uint32_t>(Op::fieldget)
+			or second.opcodes[0] != static_cast<uint32_t>(Op::jz))
+			return false;
+		auto& fieldget = first.to<Op::fieldget>();
+		auto& jz = second.to<Op::jz>();
+		if (fieldget.lvid != jz.lvid or jz.result != 0 or not isTemporary(jz.lvid))
+			return false;
+		auto& fused = out.to<Op::jzfield>();
+		fused.opcode = static_cast<uint32_t>(Op::jzfield);
+		fused.self = fieldget.self;
+		fused.var = fieldget.var;
+		fused.label = jz.label;
+		return true;
+	}
+
+	bool operator () (ir::Instruction& out, const ir::Instruction& first, const ir::Instruction& second) const {
+		return immediate(out, first, second)
+			or compareAndBranch(out, first, second)
+			or fieldAndBranch(out, first, second);
+	}
+
+	const std::vector<uint32_t>& uses;
+};
+
+} // namespace
+
+void passPeepholeIR(ir::Sequence& sequence) {
+	if (unlikely(sequence.opcodeCount() == 0
+		or sequence.at(0).opcodes[0] != static_cast<uint32_t>(Op::stacksize)))
+		return;
+	uint32_t count = stripNoops(sequence);
+	uint32_t framesize = sequence.at<Op::stacksize>(0).add;
+	auto uses = countRegisterUses(sequence, count, framesize);
+	Fusion fuse{uses};
+	uint32_t size = 1;
+	for (uint32_t i = 1; i < count; ++i) {
+		ir::Instruction fused;
+		if (i + 1 < count and fuse(fused, sequence.at(i), sequence.at(i + 1))) {
+			sequence.at(size++) = fused;
+			++i; // the next instruction has been consumed
+			continue;
+		}
+		if (size != i)
+			sequence.at(size) = sequence.at(i);
+		++size;
+	}
+	sequence.truncate(size);
+}
+
+} // ny::compiler
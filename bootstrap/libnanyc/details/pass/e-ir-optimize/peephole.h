@@ -0,0 +1,16 @@
+#pragma once
+#include "details/ir/sequence.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Peephole optimizations on the IR code of an instanciated function
+**
+** Remove all opcodes without any effect at runtime (nop, comment, scope...) and
+** fuse some common pairs of instructions into superinstructions (add with an
+** immediate value, compare-and-branch...). The first opcode (stacksize) and all
+** labels are preserved. The label index must be rebuilt afterwards.
+*/
+void passPeepholeIR(ir::Sequence&);
+
+} // ny::compiler
@@ -0,0 +1,204 @@
+#include "refcount.h"
+#include "registers.h"
+#include <utility>
+#include <vector>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+struct RefCountElision final {
+	RefCountElision(ir::Sequence& sequence)
+		: sequence(sequence)
+		, count(sequence.opcodeCount())
+		, framesize(sequence.at<Op::stacksize>(0).add) {
+	}
+
+	enum Status: uint8_t { unused, copy, written };
+
+	/*!
+	** \brief Find all registers holding a borrowed object
+	**
+	** Parameters first (never written), then their copies (only written by a copy
+	** of a borrowed register), until no new register is found. Each copy is
+	** attached to the group of its sources.
+	*/
+	bool collectBorrowed() {
+		status.assign(framesize, unused);
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			if (instr.opcodes[0] == static_cast<uint32_t>(Op::store)) {
+				auto& store = instr.to<Op::store>();
+				if (store.lvid < framesize and store.source < framesize and store.lvid != store.source) {
+					if (status[store.lvid] == unused)
+						status[store.lvid] = copy;
+					copies.emplace_back(store.lvid, store.source);
+					continue;
+				}
+			}
+			eachDefinition(instr, [&](uint32_t lvid) {
+				if (lvid < framesize)
+					status[lvid] = written;
+			});
+		}
+		group.assign(framesize, 0);
+		bool found = false;
+		for (uint32_t lvid = 2; lvid < framesize; ++lvid) { // parameters are 2-based
+			if (status[lvid] == unused) {
+				group[lvid] = lvid;
+				found = true;
+			}
+		}
+		if (not found)
+			return false;
+		bool changed;
+		do {
+			changed = false;
+			for (uint32_t lvid = 2; lvid < framesize; ++lvid) {
+				if (status[lvid] != copy or group[lvid] != 0 or not onlyCopyOfBorrowed(lvid))
+					continue;
+				for (auto& pair: copies) {
+					if (pair.first == lvid)
+						merge(lvid, pair.second);
+				}
+				changed = true;
+			}
+		}
+		while (changed);
+		return true;
+	}
+
+	bool onlyCopyOfBorrowed(uint32_t lvid) const {
+		for (auto& pair: copies) {
+			if (pair.first == lvid and group[pair.second] == 0)
+				return false;
+		}
+		return true;
+	}
+
+	//! Get the group of a borrowed register (0 if none)
+	uint32_t root(uint32_t lvid) const {
+		if (not (lvid < framesize) or group[lvid] == 0)
+			return 0;
+		while (group[lvid] != lvid)
+			lvid = group[lvid];
+		return lvid;
+	}
+
+	//! Attach a register to the group of another borrowed register
+	void merge(uint32_t lvid, uint32_t source) {
+		uint32_t target = root(source);
+		if (group[lvid] == 0) {
+			group[lvid] = target;
+			return;
+		}
+		uint32_t current = root(lvid);
+		if (current != target)
+			group[current] = target;
+	}
+
+	//! The references held by a group may be transferred outside of it, all refcounts must be kept
+	void keep(uint32_t lvid) {
+		uint32_t r = root(lvid);
+		if (r != 0)
+			kept[r] = 1;
+	}
+
+	/*!
+	** \brief Find all groups whose references may be transferred (returned value, variable member...)
+	**
+	** The refcounts of a group can only be elided when its refs and unrefs
+	** balance. An explicit ownership transfer (`!!ref(param)` then `!!pointer(param)`,
+	** for a callee or a variable member) or a lone `!!unref(param)` keeps the whole
+	** group, even if its copies are only pushed.
+	*/
+	void checkUses() {
+		kept.assign(framesize, 0);
+		std::vector<int32_t> balance(framesize, 0);
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::store: {
+					auto& store = instr.to<Op::store>();
+					if (root(store.lvid) == 0)
+						keep(store.source); // copied into a register not borrowed
+					continue;
+				}
+				case Op::ref: {
+					uint32_t r = root(instr.opcodes[1]);
+					if (r != 0)
+						++balance[r];
+					continue;
+				}
+				case Op::unref: {
+					uint32_t r = root(instr.opcodes[1]);
+					if (r != 0)
+						--balance[r];
+					continue;
+				}
+				case Op::push: // the caller holds a reference during the call
+					continue;
+				case Op::fieldget:
+				case Op::jzfield:
+					continue; // only read through 'self'
+				case Op::fieldset: {
+					keep(instr.to<Op::fieldset>().lvid); // acquired by the object
+					continue;
+				}
+				default: {
+					eachRegister(instr, [&](uint32_t lvid) { keep(lvid); });
+					continue;
+				}
+			}
+		}
+		for (uint32_t r = 2; r < framesize; ++r) {
+			if (balance[r] != 0)
+				kept[r] = 1;
+		}
+	}
+
+	bool run() {
+		if (not collectBorrowed())
+			return false;
+		checkUses();
+		uint32_t removed = 0;
+		for (uint32_t i = 1; i != count; ++i) {
+			auto& instr = sequence.at(i);
+			uint32_t opcode = instr.opcodes[0];
+			if (opcode != static_cast<uint32_t>(Op::ref) and opcode != static_cast<uint32_t>(Op::unref))
+				continue;
+			uint32_t r = root(instr.opcodes[1]);
+			if (r != 0 and kept[r] == 0) {
+				instr.opcodes[0] = static_cast<uint32_t>(Op::nop);
+				++removed;
+			}
+		}
+		return removed != 0;
+	}
+
+	ir::Sequence& sequence;
+	const uint32_t count;
+	const uint32_t framesize;
+	//! How each register is written
+	std::vector<Status> status;
+	//! All copies between registers {destination, source}
+	std::vector<std::pair<uint32_t, uint32_t>> copies;
+	//! Borrowed registers, as a forest (parent register, 0 if not borrowed)
+	std::vector<uint32_t> group;
+	//! Groups whose refcounts must be kept (1 if kept, indexed by the root register)
+	std::vector<uint8_t> kept;
+};
+
+} // namespace
+
+void passRefCountElisionIR(ir::Sequence& sequence) {
+	if (unlikely(sequence.opcodeCount() == 0
+		or sequence.at(0).opcodes[0] != static_cast<uint32_t>(Op::stacksize)))
+		return;
+	RefCountElision pass{sequence};
+	pass.run();
+}
+
+} // ny::compiler
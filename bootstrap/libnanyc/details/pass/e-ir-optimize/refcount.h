@@ -0,0 +1,20 @@
+#pragma once
+#include "details/ir/sequence.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Remove the redundant `ref`/`unref` of the objects borrowed from the caller
+**
+** The registers never written by a function are its parameters: the objects
+** they hold are kept alive by the caller for the whole duration of the call.
+** All `ref`/`unref` of such register, and of all its copies (registers only
+** written by a copy of another one of the group), are useless as long as no
+** reference is transferred outside of the group (returned value, object stored
+** into a variable member or into another register...).
+**
+** Must be called before the peephole pass (the removed opcodes become `nop`).
+*/
+void passRefCountElisionIR(ir::Sequence&);
+
+} // ny::compiler
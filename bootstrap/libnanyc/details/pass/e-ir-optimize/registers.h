@@ -0,0 +1,243 @@
+#pragma once
+#include "details/ir/sequence.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Visit each operand which may be a register
+**
+** Conservative: each operand is considered as a register, whatever the opcode
+** (see passPeepholeIR()).
+*/
+template<class F> void eachRegister(const ir::Instruction& instr, const F& callback) {
+	using Op = ir::isa::Op;
+	if (instr.opcodes[0] == static_cast<uint32_t>(Op::storeConstant)) {
+		callback(instr.opcodes[1]); // the other words are the value itself
+		return;
+	}
+	callback(instr.opcodes[1]);
+	callback(instr.opcodes[2]);
+	callback(instr.opcodes[3]);
+	switch (static_cast<Op>(instr.opcodes[0])) {
+		case Op::raise:
+		case Op::jmperrhandler:
+		case Op::onscopefail: {
+			callback(instr.opcodes[2] + 1); // the error is stored into the register 'label + 1'
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+//! Visit each register which may be written by an instruction (conservative)
+template<class F> void eachDefinition(const ir::Instruction& instr, const F& callback) {
+	using Op = ir::isa::Op;
+	switch (static_cast<Op>(instr.opcodes[0])) {
+		case Op::nop:
+		case Op::comment:
+		case Op::scope:
+		case Op::end:
+		case Op::stackalloc:
+		case Op::label:
+		case Op::jmp:
+		case Op::jzraise:
+		case Op::ref:
+		case Op::unref:
+		case Op::push:
+		case Op::ret:
+		case Op::opassert:
+		case Op::fieldset:
+		case Op::jzfield:
+		case Op::jzeq:
+		case Op::jzneq:
+		case Op::jzlt:
+		case Op::jzilt:
+		case Op::jzlte:
+		case Op::jzilte:
+		case Op::store_u64:
+		case Op::store_u32:
+		case Op::store_u8:
+		case Op::memfill:
+		case Op::memcopy:
+		case Op::memmove:
+		case Op::memfree:
+		case Op::memcheckhold:
+			return;
+		case Op::jz:
+		case Op::jnz: {
+			callback(instr.to<Op::jz>().result);
+			return;
+		}
+		case Op::store:
+		case Op::storeConstant:
+		case Op::storeText:
+		case Op::fieldget:
+		case Op::memalloc:
+		case Op::memrealloc:
+		case Op::classdefsizeof:
+		case Op::call:
+		case Op::fcall:
+		case Op::spawn:
+		case Op::await:
+		case Op::intrinsic:
+		case Op::negation:
+		case Op::as:
+		case Op::load_u64:
+		case Op::load_u32:
+		case Op::load_u8:
+		case Op::cstrlen:
+		case Op::addimm:
+		case Op::subimm: {
+			callback(instr.opcodes[1]);
+			return;
+		}
+		default: {
+			eachRegister(instr, callback);
+			return;
+		}
+	}
+}
+
+//! Get the label targeted by an instruction (0 if none)
+inline uint32_t jumpTarget(const ir::Instruction& instr) {
+	using Op = ir::isa::Op;
+	switch (static_cast<Op>(instr.opcodes[0])) {
+		case Op::jmp:
+		case Op::jzraise:
+			return instr.opcodes[1];
+		case Op::jmperrhandler:
+		case Op::raise:
+			return instr.opcodes[2];
+		case Op::jz:
+		case Op::jnz:
+		case Op::jzeq:
+		case Op::jzneq:
+		case Op::jzlt:
+		case Op::jzilt:
+		case Op::jzlte:
+		case Op::jzilte:
+		case Op::jzfield:
+			return instr.opcodes[3];
+		default:
+			return 0;
+	}
+}
+
+/*!
+** \brief Visit each register operand of an instruction, to renumber them
+**
+** Unlike eachRegister(), only the words really holding a register are visited.
+** The register 'label + 1' of the error handlers is not an operand.
+** \return False if the operands of the opcode are not known
+*/
+template<class F> bool eachRegisterOperand(ir::Instruction& instr, const F& callback) {
+	using Op = ir::isa::Op;
+	auto& operands = instr.opcodes;
+	switch (static_cast<Op>(operands[0])) {
+		case Op::nop:
+		case Op::comment:
+		case Op::scope:
+		case Op::end:
+		case Op::label:
+		case Op::jmp:
+		case Op::jzraise:
+		case Op::jmperrhandler:
+			return true;
+		case Op::opand:
+		case Op::opor:
+		case Op::opxor:
+		case Op::opmod:
+		case Op::opmodi:
+		case Op::eq:
+		case Op::neq:
+		case Op::lt:
+		case Op::ilt:
+		case Op::lte:
+		case Op::ilte:
+		case Op::gt:
+		case Op::igt:
+		case Op::gte:
+		case Op::igte:
+		case Op::flt:
+		case Op::flte:
+		case Op::fgt:
+		case Op::fgte:
+		case Op::add:
+		case Op::sub:
+		case Op::mul:
+		case Op::div:
+		case Op::imul:
+		case Op::idiv:
+		case Op::fadd:
+		case Op::fsub:
+		case Op::fmul:
+		case Op::fdiv:
+		case Op::memfill:
+		case Op::memcopy:
+		case Op::memmove:
+		case Op::memcmp:
+		case Op::memrealloc: {
+			callback(operands[1]);
+			callback(operands[2]);
+			callback(operands[3]);
+			return true;
+		}
+		case Op::negation:
+		case Op::store:
+		case Op::as:
+		case Op::load_u64:
+		case Op::load_u32:
+		case Op::load_u8:
+		case Op::store_u64:
+		case Op::store_u32:
+		case Op::store_u8:
+		case Op::memalloc:
+		case Op::memfree:
+		case Op::memcheckhold:
+		case Op::addimm:
+		case Op::subimm:
+		case Op::fieldget:
+		case Op::fieldset:
+		case Op::jz:
+		case Op::jnz:
+		case Op::jzeq:
+		case Op::jzneq:
+		case Op::jzlt:
+		case Op::jzilt:
+		case Op::jzlte:
+		case Op::jzilte: {
+			callback(operands[1]);
+			callback(operands[2]);
+			return true;
+		}
+		case Op::cstrlen: {
+			callback(operands[1]);
+			callback(operands[3]); // the 2nd operand is the number of bits
+			return true;
+		}
+		case Op::storeConstant: // the other words are the value itself
+		case Op::storeText:
+		case Op::stackalloc:
+		case Op::ref:
+		case Op::unref:
+		case Op::opassert:
+		case Op::classdefsizeof:
+		case Op::push:
+		case Op::call:
+		case Op::fcall:
+		case Op::spawn:
+		case Op::await:
+		case Op::intrinsic:
+		case Op::ret:
+		case Op::raise:
+		case Op::jzfield: {
+			callback(operands[1]);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+} // ny::compiler
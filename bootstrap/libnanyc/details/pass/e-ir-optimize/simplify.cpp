@@ -0,0 +1,523 @@
+#include "simplify.h"
+#include "registers.h"
+#include <algorithm>
+#include <vector>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+union Value {
+	uint64_t u64;
+	int64_t i64;
+	double f64;
+};
+
+void nop(ir::Instruction& instr) {
+	instr.opcodes[0] = static_cast<uint32_t>(Op::nop);
+}
+
+//! Get if an instruction can not go to the next one
+bool isTerminator(const ir::Instruction& instr) {
+	switch (static_cast<Op>(instr.opcodes[0])) {
+		case Op::jmp:
+		case Op::ret:
+		case Op::raise:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//! Get if an instruction only writes its first operand, without any other side effect
+bool isPure(Op opcode) {
+	switch (opcode) {
+		case Op::store:
+		case Op::storeConstant:
+		case Op::storeText:
+		case Op::classdefsizeof:
+		case Op::negation:
+		case Op::add:
+		case Op::sub:
+		case Op::mul:
+		case Op::imul:
+		case Op::fadd:
+		case Op::fsub:
+		case Op::fmul:
+		case Op::addimm:
+		case Op::subimm:
+		case Op::opand:
+		case Op::opor:
+		case Op::opxor:
+		case Op::eq:
+		case Op::neq:
+		case Op::lt:
+		case Op::lte:
+		case Op::gt:
+		case Op::gte:
+		case Op::ilt:
+		case Op::ilte:
+		case Op::igt:
+		case Op::igte:
+		case Op::flt:
+		case Op::flte:
+		case Op::fgt:
+		case Op::fgte:
+			return true;
+		default:
+			return false;
+	}
+}
+
+struct Simplifier final {
+	Simplifier(ir::Sequence& sequence, uint32_t reserved)
+		: framesize(sequence.at<Op::stacksize>(0).add)
+		, reserved(std::min(reserved, framesize)) {
+		uint32_t count = sequence.opcodeCount();
+		code.reserve(count);
+		for (uint32_t i = 0; i != count; ++i)
+			code.push_back(sequence.at(i));
+	}
+
+	bool valueOf(uint32_t lvid, Value& value) const {
+		if (lvid < framesize and known[lvid] != 0) {
+			value.u64 = values[lvid];
+			return true;
+		}
+		return false;
+	}
+
+	//! Get if the divisor of a division is a constant which can not throw or overflow
+	bool isSafeDivisor(const ir::Instruction& instr) const {
+		Value rhs;
+		if (not valueOf(instr.opcodes[3], rhs) or rhs.u64 == 0)
+			return false;
+		switch (static_cast<Op>(instr.opcodes[0])) {
+			case Op::idiv:
+			case Op::opmodi:
+				return rhs.i64 != -1;
+			default:
+				return true;
+		}
+	}
+
+	//! Evaluate an instruction whose operands are all constants
+	bool evaluate(const ir::Instruction& instr, Value& result) const {
+		auto& operands = instr.opcodes;
+		Value lhs, rhs;
+		switch (static_cast<Op>(operands[0])) {
+			case Op::store:
+				return valueOf(operands[2], result);
+			case Op::negation: {
+				if (not valueOf(operands[2], lhs))
+					return false;
+				result.u64 = (lhs.u64 == 0) ? 1 : 0;
+				return true;
+			}
+			case Op::add: case Op::sub: case Op::mul: case Op::div:
+			case Op::imul: case Op::idiv: case Op::opmod: case Op::opmodi:
+			case Op::opand: case Op::opor: case Op::opxor:
+			case Op::eq: case Op::neq: case Op::lt: case Op::lte: case Op::gt: case Op::gte:
+			case Op::ilt: case Op::ilte: case Op::igt: case Op::igte:
+			case Op::flt: case Op::flte: case Op::fgt: case Op::fgte:
+			case Op::fadd: case Op::fsub: case Op::fmul: {
+				if (not valueOf(operands[2], lhs) or not valueOf(operands[3], rhs))
+					return false;
+				break;
+			}
+			default:
+				return false;
+		}
+		switch (static_cast<Op>(operands[0])) {
+			case Op::add:   result.u64 = lhs.u64 + rhs.u64; break;
+			case Op::sub:   result.u64 = lhs.u64 - rhs.u64; break;
+			case Op::mul:   result.u64 = lhs.u64 * rhs.u64; break;
+			case Op::imul:  result.u64 = lhs.u64 * rhs.u64; break; // same bits, without signed overflow
+			case Op::opand: result.u64 = lhs.u64 & rhs.u64; break;
+			case Op::opor:  result.u64 = lhs.u64 | rhs.u64; break;
+			case Op::opxor: result.u64 = lhs.u64 ^ rhs.u64; break;
+			case Op::eq:    result.u64 = (lhs.u64 == rhs.u64) ? 1 : 0; break;
+			case Op::neq:   result.u64 = (lhs.u64 != rhs.u64) ? 1 : 0; break;
+			case Op::lt:    result.u64 = (lhs.u64 <  rhs.u64) ? 1 : 0; break;
+			case Op::lte:   result.u64 = (lhs.u64 <= rhs.u64) ? 1 : 0; break;
+			case Op::gt:    result.u64 = (lhs.u64 >  rhs.u64) ? 1 : 0; break;
+			case Op::gte:   result.u64 = (lhs.u64 >= rhs.u64) ? 1 : 0; break;
+			case Op::ilt:   result.u64 = (lhs.i64 <  rhs.i64) ? 1 : 0; break;
+			case Op::ilte:  result.u64 = (lhs.i64 <= rhs.i64) ? 1 : 0; break;
+			case Op::igt:   result.u64 = (lhs.i64 >  rhs.i64) ? 1 : 0; break;
+			case Op::igte:  result.u64 = (lhs.i64 >= rhs.i64) ? 1 : 0; break;
+			case Op::flt:   result.u64 = (lhs.f64 <  rhs.f64) ? 1 : 0; break;
+			case Op::flte:  result.u64 = (lhs.f64 <= rhs.f64) ? 1 : 0; break;
+			case Op::fgt:   result.u64 = (lhs.f64 >  rhs.f64) ? 1 : 0; break;
+			case Op::fgte:  result.u64 = (lhs.f64 >= rhs.f64) ? 1 : 0; break;
+			case Op::fadd:  result.f64 = lhs.f64 + rhs.f64; break;
+			case Op::fsub:  result.f64 = lhs.f64 - rhs.f64; break;
+			case Op::fmul:  result.f64 = lhs.f64 * rhs.f64; break;
+			case Op::div:
+			case Op::opmod: {
+				if (rhs.u64 == 0)
+					return false; // division by zero, raised at runtime
+				result.u64 = (operands[0] == static_cast<uint32_t>(Op::div))
+					? lhs.u64 / rhs.u64 : lhs.u64 % rhs.u64;
+				break;
+			}
+			case Op::idiv:
+			case Op::opmodi: {
+				if (not isSafeDivisor(instr))
+					return false;
+				result.i64 = (operands[0] == static_cast<uint32_t>(Op::idiv))
+					? lhs.i64 / rhs.i64 : lhs.i64 % rhs.i64;
+				break;
+			}
+			default:
+				return false;
+		}
+		return true;
+	}
+
+	/*!
+	** \brief Replace all operations on constants by constants
+	**
+	** A register written only once by a constant holds this constant wherever
+	** it is read (the registers are never read before being written), except
+	** the reserved ones: the parameters are already set by the caller.
+	*/
+	bool foldConstants() {
+		uint32_t count = static_cast<uint32_t>(code.size());
+		std::vector<uint32_t> definitions(framesize, 0);
+		for (uint32_t i = 1; i != count; ++i) {
+			eachDefinition(code[i], [&](uint32_t lvid) {
+				if (lvid < framesize)
+					++definitions[lvid];
+			});
+		}
+		known.assign(framesize, 0);
+		values.assign(framesize, 0);
+		bool changed = false;
+		bool progress;
+		do {
+			progress = false;
+			for (uint32_t i = 1; i != count; ++i) {
+				auto& instr = code[i];
+				uint32_t lvid = instr.opcodes[1];
+				if (not (lvid < framesize) or known[lvid] != 0)
+					continue;
+				Value value;
+				if (instr.opcodes[0] == static_cast<uint32_t>(Op::storeConstant))
+					value.u64 = instr.to<Op::storeConstant>().value.u64;
+				else if (evaluate(instr, value)) {
+					auto& constant = instr.to<Op::storeConstant>();
+					constant.opcode = static_cast<uint32_t>(Op::storeConstant);
+					constant.lvid = lvid;
+					constant.value.u64 = value.u64;
+					changed = true;
+				}
+				else
+					continue;
+				if (definitions[lvid] == 1 and lvid >= reserved and lvid != 0) {
+					known[lvid] = 1;
+					values[lvid] = value.u64;
+					progress = true;
+				}
+			}
+		}
+		while (progress);
+		return changed;
+	}
+
+	//! Replace the conditional jumps on constants
+	bool foldBranches() {
+		bool changed = false;
+		for (uint32_t i = 1; i < static_cast<uint32_t>(code.size()); ++i) {
+			auto& instr = code[i];
+			Value condition;
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::jz:
+				case Op::jnz: {
+					if (not valueOf(instr.opcodes[1], condition))
+						break;
+					bool onzero = instr.opcodes[0] == static_cast<uint32_t>(Op::jz);
+					if ((condition.u64 == 0) != onzero) {
+						nop(instr); // never taken
+						changed = true;
+						break;
+					}
+					auto operands = instr.to<Op::jz>();
+					auto& jump = instr.to<Op::jmp>();
+					jump.opcode = static_cast<uint32_t>(Op::jmp);
+					jump.label = operands.label;
+					if (operands.result != 0) {
+						// the result is set before jumping
+						alignas(8) ir::Instruction store; // storeConstant has a 64bits member
+						auto& constant = store.to<Op::storeConstant>();
+						constant.opcode = static_cast<uint32_t>(Op::storeConstant);
+						constant.lvid = operands.result;
+						constant.value.u64 = onzero ? 0 : 1;
+						code.insert(code.begin() + i, store);
+						++i;
+					}
+					changed = true;
+					break;
+				}
+				case Op::opassert: {
+					if (valueOf(instr.opcodes[1], condition) and condition.u64 != 0) {
+						nop(instr);
+						changed = true;
+					}
+					break;
+				}
+				default:
+					break;
+			}
+		}
+		// jumps to the next instruction
+		uint32_t count = static_cast<uint32_t>(code.size());
+		for (uint32_t i = 1; i != count; ++i) {
+			if (code[i].opcodes[0] != static_cast<uint32_t>(Op::jmp))
+				continue;
+			uint32_t next = i + 1;
+			while (next < count and code[next].opcodes[0] == static_cast<uint32_t>(Op::nop))
+				++next;
+			if (next < count and code[next].opcodes[0] == static_cast<uint32_t>(Op::label)
+				and code[next].to<Op::label>().label == code[i].to<Op::jmp>().label) {
+				nop(code[i]);
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	//! Remove the unreachable code and the labels no longer used
+	bool removeUnreachable() {
+		uint32_t count = static_cast<uint32_t>(code.size());
+		std::vector<uint32_t> labels;
+		for (uint32_t i = 1; i != count; ++i) {
+			switch (static_cast<Op>(code[i].opcodes[0])) {
+				case Op::label: {
+					uint32_t label = code[i].to<Op::label>().label;
+					if (labels.size() <= label)
+						labels.resize(label + 1, 0u);
+					if (labels[label] != 0)
+						return false; // the jumps can not be resolved
+					labels[label] = i;
+					break;
+				}
+				case Op::onscopefail:
+					return false;
+				default:
+					break;
+			}
+		}
+		std::vector<uint8_t> reachable(count, 0);
+		std::vector<uint32_t> pending{1};
+		while (not pending.empty()) {
+			uint32_t i = pending.back();
+			pending.pop_back();
+			for (; i < count and reachable[i] == 0; ++i) {
+				reachable[i] = 1;
+				uint32_t label = jumpTarget(code[i]);
+				if (label != 0) {
+					if (not (label < labels.size()) or labels[label] == 0)
+						return false; // unknown label
+					pending.push_back(labels[label]);
+				}
+				if (isTerminator(code[i]))
+					break;
+			}
+		}
+		bool changed = false;
+		std::vector<uint32_t> jumps(labels.size(), 0);
+		for (uint32_t i = 1; i != count; ++i) {
+			if (reachable[i] == 0) {
+				if (code[i].opcodes[0] != static_cast<uint32_t>(Op::nop)) {
+					nop(code[i]);
+					changed = true;
+				}
+				continue;
+			}
+			uint32_t label = jumpTarget(code[i]);
+			if (label != 0)
+				++jumps[label];
+		}
+		for (uint32_t i = 1; i != count; ++i) {
+			if (code[i].opcodes[0] == static_cast<uint32_t>(Op::label) and jumps[code[i].to<Op::label>().label] == 0) {
+				nop(code[i]);
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	//! Visit each register read by an instruction (conservative)
+	template<class F> static void eachRead(const ir::Instruction& instr, const F& callback) {
+		auto opcode = static_cast<Op>(instr.opcodes[0]);
+		if (opcode == Op::storeConstant)
+			return;
+		if (isPure(opcode) or opcode == Op::div or opcode == Op::idiv
+			or opcode == Op::opmod or opcode == Op::opmodi) {
+			callback(instr.opcodes[2]);
+			callback(instr.opcodes[3]);
+			return;
+		}
+		if (opcode == Op::jz or opcode == Op::jnz) {
+			callback(instr.opcodes[1]); // the result is only written
+			return;
+		}
+		eachRegister(instr, callback);
+	}
+
+	//! Remove the side-effect free operations whose result is never read
+	bool removeDeadDefinitions() {
+		uint32_t count = static_cast<uint32_t>(code.size());
+		std::vector<uint32_t> reads(framesize, 0);
+		auto read = [&](uint32_t lvid) {
+			if (lvid < framesize)
+				++reads[lvid];
+		};
+		auto unread = [&](uint32_t lvid) {
+			if (lvid < framesize and reads[lvid] != 0)
+				--reads[lvid];
+		};
+		for (uint32_t i = 1; i != count; ++i)
+			eachRead(code[i], read);
+		bool changed = false;
+		bool progress;
+		do {
+			progress = false;
+			for (uint32_t i = count; --i != 0; ) {
+				auto& instr = code[i];
+				auto opcode = static_cast<Op>(instr.opcodes[0]);
+				bool removable = isPure(opcode);
+				if (not removable) {
+					switch (opcode) {
+						case Op::div:
+						case Op::idiv:
+						case Op::opmod:
+						case Op::opmodi:
+							removable = isSafeDivisor(instr);
+							break;
+						default:
+							break;
+					}
+				}
+				uint32_t lvid = instr.opcodes[1];
+				// %0 is a sink and %1 the return value
+				if (not removable or lvid < 2 or not (lvid < framesize) or reads[lvid] != 0)
+					continue;
+				eachRead(instr, unread);
+				nop(instr);
+				progress = changed = true;
+			}
+		}
+		while (progress);
+		return changed;
+	}
+
+	//! Renumber the registers still used, to shrink the frame
+	bool compactRegisters() {
+		// the parameters and the registers used by the error handlers (depending on the labels)
+		std::vector<uint8_t> fixed(framesize, 0);
+		std::vector<uint8_t> used(framesize, 0);
+		for (uint32_t lvid = 0; lvid < reserved; ++lvid)
+			fixed[lvid] = used[lvid] = 1;
+		for (uint32_t i = 1; i != static_cast<uint32_t>(code.size()); ++i) {
+			auto& instr = code[i];
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::raise:
+				case Op::jmperrhandler: {
+					uint32_t lvid = instr.opcodes[2] + 1; // the error is stored into the register 'label + 1'
+					if (lvid < framesize)
+						fixed[lvid] = used[lvid] = 1;
+					break;
+				}
+				default:
+					break;
+			}
+			bool valid = true;
+			bool supported = eachRegisterOperand(instr, [&](uint32_t& lvid) {
+				if (lvid < framesize)
+					used[lvid] = 1;
+				else
+					valid = false;
+			});
+			if (not supported or not valid)
+				return false; // some operands are unknown
+		}
+		std::vector<uint32_t> renumber(framesize, 0);
+		std::vector<uint8_t> taken = fixed;
+		uint32_t next = 0;
+		uint32_t upper = reserved;
+		for (uint32_t lvid = 0; lvid != framesize; ++lvid) {
+			if (used[lvid] == 0)
+				continue;
+			if (fixed[lvid] != 0)
+				renumber[lvid] = lvid;
+			else {
+				while (taken[next] != 0)
+					++next;
+				renumber[lvid] = next;
+				taken[next] = 1;
+			}
+			upper = std::max(upper, renumber[lvid] + 1);
+		}
+		if (upper >= framesize)
+			return false;
+		for (uint32_t i = 1; i != static_cast<uint32_t>(code.size()); ++i)
+			eachRegisterOperand(code[i], [&](uint32_t& lvid) { lvid = renumber[lvid]; });
+		framesize = upper;
+		return true;
+	}
+
+	void removeNops() {
+		auto isnop = [](const ir::Instruction& instr) {
+			return instr.opcodes[0] == static_cast<uint32_t>(Op::nop);
+		};
+		code.erase(std::remove_if(code.begin() + 1, code.end(), isnop), code.end());
+	}
+
+	bool run() {
+		bool changed = false;
+		for (uint32_t round = 0; round != 4; ++round) {
+			bool progress = foldConstants();
+			progress |= foldBranches();
+			progress |= removeUnreachable();
+			progress |= removeDeadDefinitions();
+			removeNops();
+			if (not progress)
+				break;
+			changed = true;
+		}
+		changed |= compactRegisters();
+		return changed;
+	}
+
+	//! The IR code of the function (stacksize first)
+	std::vector<ir::Instruction> code;
+	//! Number of registers
+	uint32_t framesize;
+	//! Number of registers which can not be renumbered
+	const uint32_t reserved;
+	//! Registers holding a constant everywhere (1 if known)
+	std::vector<uint8_t> known;
+	//! Value of the registers holding a constant
+	std::vector<uint64_t> values;
+};
+
+} // namespace
+
+void passSimplifyIR(ir::Sequence& sequence, uint32_t reserved) {
+	if (unlikely(sequence.opcodeCount() == 0
+		or sequence.at(0).opcodes[0] != static_cast<uint32_t>(Op::stacksize)))
+		return;
+	Simplifier simplifier{sequence, reserved};
+	if (not simplifier.run())
+		return;
+	auto& code = simplifier.code;
+	sequence.at<Op::stacksize>(0).add = simplifier.framesize;
+	sequence.truncate(1);
+	sequence.append(code.data() + 1, static_cast<uint32_t>(code.size()) - 1);
+}
+
+} // ny::compiler
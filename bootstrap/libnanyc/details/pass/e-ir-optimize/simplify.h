@@ -0,0 +1,21 @@
+#pragma once
+#include "details/ir/sequence.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Simplify the IR code of an instanciated function
+**
+** - constant folding: the operations on registers written once by a constant
+**   become constants as well (`storeConstant`)
+** - branch folding: the conditional jumps on constants become `jmp` or are removed
+** - dead code elimination: unreachable code, unused labels and side-effect free
+**   operations whose result is never read
+** - register compaction: the registers no longer used are removed from the frame
+**
+** Must be called before the peephole pass (the superinstructions are not folded).
+** \param reserved Number of registers which can not be renumbered (return value, parameters)
+*/
+void passSimplifyIR(ir::Sequence&, uint32_t reserved);
+
+} // ny::compiler
@@ -0,0 +1,185 @@
+#include "link.h"
+#include <unordered_map>
+
+namespace ny::compiler {
+
+namespace {
+
+using Op = ir::isa::Op;
+
+struct Linker final {
+	Linker(Compdb& compdb)
+		: functions(compdb.functions)
+		, ids(compdb.functionIDs) {
+	}
+
+	static uint64_t key(uint32_t atomid, uint32_t instanceid) {
+		return (static_cast<uint64_t>(atomid) << 32) | instanceid;
+	}
+
+	//! Get if a function does nothing at all
+	static bool isTrivial(const ir::Sequence& ircode) {
+		uint32_t count = ircode.opcodeCount();
+		for (uint32_t i = 1; i < count; ++i) {
+			switch (static_cast<Op>(ircode.at(i).opcodes[0])) {
+				case Op::nop:
+				case Op::comment:
+				case Op::scope:
+				case Op::end:
+				case Op::stackalloc:
+				case Op::ret:
+					break;
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void declare(Atom& atom) {
+		uint64_t objectsize = 0;
+		if (atom.isDtor() and atom.parent != nullptr)
+			objectsize = atom.parent->runtimeSizeof() + config::extraObjectSize;
+		uint32_t count = atom.instances.size();
+		for (uint32_t i = 0; i != count; ++i) {
+			auto* ircode = atom.instances[i].ircodeIfExists();
+			if (ircode == nullptr or ircode->opcodeCount() == 0)
+				continue;
+			assert(ircode->at(0).opcodes[0] == static_cast<uint32_t>(Op::stacksize));
+			ids.emplace(key(atom.atomid, i), static_cast<uint32_t>(functions.size()));
+			sequences.emplace_back(ircode);
+			functions.emplace_back();
+			auto& func = functions.back();
+			func.ircode = ircode;
+			func.framesize = ircode->at<Op::stacksize>(0).add;
+			func.atomid = atom.atomid;
+			func.instanceid = i;
+			func.objectsize = objectsize;
+			func.trivial = (objectsize != 0) and isTrivial(*ircode);
+		}
+	}
+
+	void declareAll(Atom& atom) {
+		atom.eachChild([&](Atom& child) -> bool {
+			if (child.isFunction())
+				declare(child);
+			declareAll(child);
+			return true;
+		});
+	}
+
+	uint32_t find(uint32_t atomid, uint32_t instanceid) const {
+		auto it = ids.find(key(atomid, instanceid));
+		return (it != ids.end()) ? it->second : (uint32_t) -1;
+	}
+
+	void resolve(ir::Sequence& ircode) {
+		uint32_t count = ircode.opcodeCount();
+		for (uint32_t i = 1; i < count; ++i) {
+			auto& instr = ircode.at(i);
+			switch (static_cast<Op>(instr.opcodes[0])) {
+				case Op::call: {
+					auto& call = instr.to<Op::call>();
+					if (call.instanceid == (uint32_t) -1)
+						break;
+					uint32_t func = find(call.ptr2func, call.instanceid);
+					if (func != (uint32_t) -1) {
+						uint32_t lvid = call.lvid;
+						uint32_t atomid = call.ptr2func;
+						auto& fcall = instr.to<Op::fcall>();
+						fcall.opcode = static_cast<uint32_t>(Op::fcall);
+						fcall.lvid = lvid;
+						fcall.func = func;
+						fcall.atomid = atomid;
+					}
+					break;
+				}
+				case Op::unref: {
+					auto& unref = instr.to<Op::unref>();
+					if (unref.atomid != 0)
+						unref.dtor = find(unref.atomid, 0); // always only one version of the dtor
+					break;
+				}
+				default:
+					break;
+			}
+		}
+		mergeUnrefs(ircode);
+	}
+
+	//! Get if an instruction releases a register with a trivial dtor
+	bool isTrivialUnref(const ir::Instruction& instr) const {
+		if (instr.opcodes[0] != static_cast<uint32_t>(Op::unref))
+			return false;
+		uint32_t dtor = instr.to<Op::unref>().dtor;
+		return dtor != (uint32_t) -1 and functions[dtor].trivial;
+	}
+
+	/*!
+	** \brief Merge consecutive unrefs of a contiguous range of registers into a single `unrefrange`
+	**
+	** The scoped variables are released in the reverse order (see
+	** `releaseScopedVariables()`). Only objects with the same trivial dtor are
+	** merged, since the VM can not suspend the release of a range to call a dtor.
+	*/
+	void mergeUnrefs(ir::Sequence& ircode) {
+		uint32_t count = ircode.opcodeCount();
+		uint32_t out = 1;
+		for (uint32_t i = 1; i < count; ) {
+			uint32_t range = 1;
+			if (isTrivialUnref(ircode.at(i))) {
+				auto& first = ircode.at(i).to<Op::unref>();
+				while (i + range < count and isTrivialUnref(ircode.at(i + range))) {
+					auto& next = ircode.at(i + range).to<Op::unref>();
+					if (next.dtor != first.dtor or next.lvid + range != first.lvid or next.lvid == 0)
+						break;
+					++range;
+				}
+			}
+			if (range > 1) {
+				uint32_t lvid = ircode.at(i + range - 1).opcodes[1];
+				uint32_t dtor = ircode.at(i).to<Op::unref>().dtor;
+				auto& unrefs = ircode.at(out).to<Op::unrefrange>();
+				unrefs.opcode = static_cast<uint32_t>(Op::unrefrange);
+				unrefs.lvid = lvid;
+				unrefs.count = range;
+				unrefs.dtor = dtor;
+			}
+			else if (out != i)
+				ircode.at(out) = ircode.at(i);
+			++out;
+			i += range;
+		}
+		if (out != count) {
+			bool indexed = ircode.hasLabelIndex();
+			ircode.truncate(out);
+			if (indexed)
+				ircode.indexLabels();
+		}
+	}
+
+	std::vector<Function>& functions;
+	//! All sequences to resolve (same order than functions)
+	std::vector<ir::Sequence*> sequences;
+	//! {atomid, instanceid} -> index in functions
+	std::unordered_map<uint64_t, uint32_t>& ids;
+};
+
+} // namespace
+
+void link(Compdb& compdb) {
+	compdb.functions.clear();
+	compdb.functionIDs.clear();
+	compdb.bytecodes.clear();
+	Linker linker{compdb};
+	linker.declareAll(compdb.cdeftable.atoms.root);
+	for (auto* ircode: linker.sequences)
+		linker.resolve(*ircode);
+	for (auto& func: compdb.functions) {
+		compdb.bytecodes.emplace_back();
+		compdb.bytecodes.back().build(*func.ircode);
+		func.bytecode = &compdb.bytecodes.back();
+	}
+}
+
+} // ny::compiler
@@ -0,0 +1,22 @@
+#pragma once
+#include "details/compiler/compdb.h"
+
+namespace ny::compiler {
+
+/*!
+** \brief Resolve all func calls of the instanciated code, once for all
+**
+** Each instanciated function gets a compact descriptor (see `Compdb::functions`)
+** and all resolved calls (`call`) are replaced by direct calls (`fcall`) to
+** this descriptor. The dtor of each `unref` is resolved as well, and the
+** consecutive unrefs of a range of registers are merged when the dtor does
+** nothing (`unrefrange`). This avoids looking up the atom, its instance and the
+** stack size for each call at runtime.
+**
+** Once resolved, each function is encoded into its compact runtime form (see
+** `ir::Bytecode`), the one executed by the VM.
+** \note To call once all entrypoints are instanciated
+*/
+void link(Compdb&);
+
+} // ny::compiler
@@ -3,6 +3,12 @@
 #include "details/reporting/message.h"
 #include "details/utils/origin.h"
 #include "details/pass/d-object-map/mapping.h"
+#include "details/pass/e-ir-optimize/await.h"
+#include "details/pass/e-ir-optimize/escape.h"
+#include "details/pass/e-ir-optimize/inline.h"
+#include "details/pass/e-ir-optimize/peephole.h"
+#include "details/pass/e-ir-optimize/refcount.h"
+#include "details/pass/e-ir-optimize/simplify.h"
 #include "details/errors/complain.h"
 #include "libnanyc-traces.h"
 #include "atom-factory.h"
@@ -218,6 +224,25 @@ ir::Sequence* translateAndInstanciateASTIRCode(Settings& settings, Signature& si
 			}
 		}
 		if (likely(success)) {
+			if (atom.type == Atom::Type::funcdef) {
+				ny::compiler::passAwaitIR(irout);
+				auto level = settings.compdb.opts.optimize;
+				if (level == nyoptimize_default)
+					level = nyoptimize_full;
+				if (level == nyoptimize_full) {
+					ny::compiler::passInlineIR(irout, newView.atoms(), symbolName);
+					ny::compiler::passEscapeAnalysisIR(irout, newView.atoms());
+					ny::compiler::passRefCountElisionIR(irout);
+				}
+				if (level != nyoptimize_none) {
+					// 1: return value, 2: first parameter
+					uint32_t reserved = 2 + static_cast<uint32_t>(atom.parameters.size());
+					ny::compiler::passSimplifyIR(irout, reserved);
+					ny::compiler::passPeepholeIR(irout);
+				}
+			}
+			// the sequence is now complete, all jumps can be resolved in O(1) at runtime
+			irout.indexLabels();
 			instance.update(std::move(symbolName), settings.returnType);
 			if (atomRequested.funcinfo.raisedErrors.noleaks.enabled) {
 				if (not atom.funcinfo.raisedErrors.empty())
@@ -232,6 +257,18 @@ ir::Sequence* translateAndInstanciateASTIRCode(Settings& settings, Signature& si
 	return nullptr;
 }
 
+//! Instanciate the IR code of an atom, measured by the profiler if enabled
+bool translateAndInstanciate(Settings& settings, Signature& signature) {
+	auto& profiler = settings.compdb.profiler;
+	if (likely(not profiler.enabled()))
+		return translateAndInstanciateASTIRCode(settings, signature) != nullptr;
+	uint32_t atomid = settings.atom.get().atomid; // before any specialization
+	auto mark = profiler.beginInstanciation();
+	bool success = translateAndInstanciateASTIRCode(settings, signature) != nullptr;
+	profiler.endInstanciation(atomid, mark);
+	return success;
+}
+
 bool instanciateRecursiveAtom(Settings& settings) {
 	Atom& atom = settings.atom.get();
 	if (unlikely(not atom.isFunction()))
@@ -643,13 +680,13 @@ bool instanciateAtom(Settings& settings) {
 				if (unlikely(remapAtom != nullptr)) { // the target atom may have changed (template class)
 					settings.atom = std::ref(*remapAtom);
 					if (remapAtom->isContextual())
-						return translateAndInstanciateASTIRCode(settings, signature) != nullptr;
+						return translateAndInstanciate(settings, signature);
 				}
 				return true;
 			}
 			case Tribool::Value::indeterminate: {
 				// the atom must be instanciated
-				return translateAndInstanciateASTIRCode(settings, signature) != nullptr;
+				return translateAndInstanciate(settings, signature);
 			}
 			case Tribool::Value::no: {
 				// failed to instanciate last time. error already reported
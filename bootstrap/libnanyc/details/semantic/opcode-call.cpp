@@ -39,6 +39,25 @@ void raisedErrorsFromFuncCall(Analyzer& seq, Atom& funccall) {
 		propagateRaisedErrors(localfunc, funccall);
 }
 
+//! Objects and raw pointers are owned by the memory of a single thread
+bool isShareableAcrossThreads(const Classdef& cdef) {
+	return cdef.isBuiltin() and not cdef.isRawPointer();
+}
+
+template<class P>
+bool checkAsyncFuncCall(Analyzer& seq, const Atom& atom, const P& params, uint32_t lvid) {
+	if (unlikely(not atom.funcinfo.raisedErrors.empty()))
+		return (error() << "functions raising errors can not be called asynchronously");
+	auto& cdefReturn = seq.cdeftable.classdef(CLID{seq.frame->atomid, lvid});
+	if (unlikely(not isShareableAcrossThreads(cdefReturn) and not cdefReturn.isVoid()))
+		return (error() << "asynchronous func calls only support builtin types for the returned value");
+	for (auto& element : params) {
+		if (unlikely(not isShareableAcrossThreads(seq.cdeftable.classdef(element.clid))))
+			return (error() << "asynchronous func calls only support builtin types for parameters");
+	}
+	return true;
+}
+
 template<class P, class O>
 bool fetchPushedParameters(const P& pushedparams, O& overloadMatch, const AtomStackFrame& frame) {
 	uint32_t atomid = frame.atomid;
@@ -183,12 +202,25 @@ bool emitFuncCall(Analyzer& seq, const ir::isa::Operand<ir::isa::Op::call>& oper
 		Settings settings{*atom, cdeftable, seq.compdb, params, tmplparams};
 		if (not seq.doInstanciateAtomFunc(settings.report, settings, lvid)) // instanciate the called func
 			return false;
+		bool async = (seq.asyncCall.lvid == lvid);
+		if (async) {
+			seq.asyncCall.lvid = 0;
+			if (unlikely(not checkAsyncFuncCall(seq, *atom, params, lvid)))
+				return false;
+		}
 		if (seq.canGenerateCode()) {
 			for (auto& element : params) // push all parameters
 				ir::emit::push(seq.out, element.clid.lvid());
-			ir::emit::call(seq.out, lvid, atom->atomid, settings.instanceid);
-			if (not atom->funcinfo.raisedErrors.empty())
-				raisedErrorsFromFuncCall(seq, *atom);
+			if (not async) {
+				ir::emit::call(seq.out, lvid, atom->atomid, settings.instanceid);
+				if (not atom->funcinfo.raisedErrors.empty())
+					raisedErrorsFromFuncCall(seq, *atom);
+			}
+			else {
+				// 'await' will be inserted when the result is needed (see passAwaitIR)
+				ir::emit::spawn(seq.out, lvid, atom->atomid, settings.instanceid);
+				seq.asyncCall.noErrorChecking = true;
+			}
 		}
 		return true;
 	}
@@ -333,6 +365,11 @@ bool emitPropsetCall(Analyzer& seq, const ir::isa::Operand<ir::isa::Op::call>& o
 
 } // namespace
 
+void Analyzer::visit(const ir::isa::Operand<ir::isa::Op::async>& operands) {
+	// the func call follows
+	asyncCall.lvid = operands.lvid;
+}
+
 void Analyzer::visit(const ir::isa::Operand<ir::isa::Op::call>& operands) {
 	// A 'call' can represent several language features.
 	// after AST transformation, assignments are method calls
@@ -362,6 +399,11 @@ void Analyzer::visit(const ir::isa::Operand<ir::isa::Op::call>& operands) {
 	}
 	// always remove pushed parameters, whatever the result is
 	pushedparams.clear();
+	if (unlikely(asyncCall.lvid != 0)) {
+		asyncCall.lvid = 0;
+		if (callSuccess)
+			callSuccess = (error() << "only function calls can be asynchronous");
+	}
 	if (unlikely(not callSuccess)) {
 		success = false;
 		frame->invalidate(operands.lvid);
@@ -5,6 +5,11 @@ using namespace Yuni;
 namespace ny::semantic {
 
 void Analyzer::visit(const ir::isa::Operand<ir::isa::Op::jzraise>& operands) {
+	if (asyncCall.noErrorChecking) {
+		// asynchronous func call, not raising any error
+		asyncCall.noErrorChecking = false;
+		return;
+	}
 	uint32_t label = operands.label;
 	ir::emit::jzraise(out, label);
 	bool hasErrorHandler = not onScopeFail.empty();
@@ -0,0 +1,69 @@
+#include "overload-cache.h"
+#include <yuni/core/stl/hash-combine.h>
+
+namespace ny::semantic {
+
+namespace {
+
+//! Append the type of a parameter to the key (false if the type is not strict enough)
+bool appendType(std::vector<uint64_t>& words, const ClassdefTableView& table, const CLID& clid) {
+	auto& cdef = table.classdef(clid);
+	if (not cdef.interface.empty() or not cdef.followup.empty())
+		return false; // the match would depend on the constraints
+	const Atom* atom = table.findClassdefAtom(cdef);
+	uint64_t qualifiers = static_cast<uint8_t>(cdef.qualifiers.ref)
+		| (static_cast<uint8_t>(cdef.qualifiers.constant) << 2)
+		| (static_cast<uint8_t>(cdef.qualifiers.nullable) << 4);
+	words.push_back((atom ? atom->atomid : 0u)
+		| (static_cast<uint64_t>(cdef.kind) << 32)
+		| (qualifiers << 48));
+	return true;
+}
+
+bool appendTypes(std::vector<uint64_t>& words, const ClassdefTableView& table, const std::vector<CLID>& list) {
+	words.push_back(list.size());
+	for (auto& clid: list) {
+		if (not appendType(words, table, clid))
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+bool OverloadCache::makeKey(Key& key, const std::vector<std::reference_wrapper<Atom>>& solutions,
+		const FuncOverloadMatch::Input& input, const ClassdefTableView& table) {
+	if (not input.params.named.empty() or not input.tmplparams.named.empty())
+		return false;
+	auto& words = key.words;
+	words.clear();
+	words.reserve(4 + solutions.size() + input.params.indexed.size() + input.tmplparams.indexed.size());
+	words.push_back(solutions.size());
+	for (auto& solution: solutions)
+		words.push_back(solution.get().atomid);
+	bool cacheable = appendTypes(words, table, input.rettype)
+		and appendTypes(words, table, input.tmplparams.indexed)
+		and appendTypes(words, table, input.params.indexed);
+	if (not cacheable)
+		return false;
+	size_t seed = 0;
+	for (auto word: words)
+		Yuni::HashCombine(seed, word);
+	key.hash = seed;
+	return true;
+}
+
+uint32_t OverloadCache::find(const Key& key, uint32_t generation) const {
+	auto it = m_entries.find(key);
+	if (it == m_entries.end() or it->second.generation != generation)
+		return static_cast<uint32_t>(-1);
+	return it->second.index;
+}
+
+void OverloadCache::add(Key&& key, uint32_t generation, uint32_t index) {
+	auto& entry = m_entries[std::move(key)];
+	entry.index = index;
+	entry.generation = generation;
+}
+
+} // ny::semantic
@@ -0,0 +1,56 @@
+#pragma once
+#include "libnanyc.h"
+#include "details/atom/atom.h"
+#include "details/atom/classdef-table-view.h"
+#include "func-overload-match.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace ny::semantic {
+
+/*!
+** \brief Results of the overload resolutions, by candidate set and argument types
+**
+** The same operators (ex: `+` on `u32`) are resolved again and again with the
+** same input types. The index of the chosen solution is kept so that only this
+** one has to be validated (to get the parameters of the current call).
+** Only the unambiguous resolutions without instanciation are kept.
+** \note This class is not thread-safe (the semantic analysis is sequential)
+*/
+struct OverloadCache final {
+	struct Key final {
+		bool operator == (const Key& rhs) const { return words == rhs.words; }
+		//! Atom ids of the solutions, then the types of the input parameters
+		std::vector<uint64_t> words;
+		size_t hash = 0;
+	};
+
+	/*!
+	** \brief Build the key of a func call
+	**
+	** \return False if the resolution can not be cached (named parameters, constraints...)
+	*/
+	static bool makeKey(Key& key, const std::vector<std::reference_wrapper<Atom>>& solutions,
+		const FuncOverloadMatch::Input& input, const ClassdefTableView& table);
+
+	//! Get the index of the solution previously chosen (-1 if not found or obsolete)
+	uint32_t find(const Key& key, uint32_t generation) const;
+	//! Keep the index of the solution chosen for a func call
+	void add(Key&& key, uint32_t generation, uint32_t index);
+
+private:
+	struct Hasher final {
+		size_t operator () (const Key& key) const { return key.hash; }
+	};
+	struct Entry final {
+		//! Index of the solution
+		uint32_t index;
+		//! Value of `Symbols::generation` when resolved
+		uint32_t generation;
+	};
+	std::unordered_map<Key, Entry, Hasher> m_entries;
+
+}; // struct OverloadCache
+
+} // ny::semantic
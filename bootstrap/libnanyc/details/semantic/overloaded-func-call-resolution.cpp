@@ -29,10 +29,32 @@ bool OverloadedFuncCallResolver::resolve(const std::vector<std::reference_wrappe
 	subreports.resize(solutionCount);
 	// parameter instanciation per solution
 	parameters.resize(solutionCount);
+	// the same func call may have already been resolved with the same input types,
+	// in this case only the previous solution has to be validated again
+	OverloadCache::Key key;
+	bool cacheable = OverloadCache::makeKey(key, solutions, overloadMatch.input, cdeftable);
+	uint32_t generation = cdeftable.atoms().symbols.generation;
+	if (cacheable) {
+		uint32_t r = compdb.overloads.find(key, generation);
+		if (r < solutionCount and TypeCheck::Match::none != overloadMatch.validate(solutions[r].get())) {
+			suitableCount = 1;
+			suitable[r] = true;
+			scores[r] = overloadMatch.result.score;
+			atom = &(solutions[r].get());
+			parameters[r].first.swap(overloadMatch.result.params);
+			parameters[r].second.swap(overloadMatch.result.tmplparams);
+			params     = &(parameters[r].first);
+			tmplparams = &(parameters[r].second);
+			return true;
+		}
+	}
+	// index of the solution, if found without instanciation
+	uint32_t solutionIndex = static_cast<uint32_t>(-1);
 	// the last perfect match found
 	Atom* perfectMatch = nullptr;
 	ParameterTypesRequested* perfectMatchParams = nullptr;
 	ParameterTypesRequested* perfectMatchTmplParams = nullptr;
+	uint32_t perfectMatchIndex = 0;
 	// flag for determine whether a perfect match has really been found (and not invalidated a posteriori)
 	uint32_t perfectMatchCount = 0;
 	// trying to find all suitable solutions
@@ -56,12 +78,14 @@ bool OverloadedFuncCallResolver::resolve(const std::vector<std::reference_wrappe
 				parameters[r].second.swap(overloadMatch.result.tmplparams);
 				params     = &(parameters[r].first);
 				tmplparams = &(parameters[r].second);
+				solutionIndex = r;
 				// Found a perfect match ! Keeping traces of it to reuse it later if it is _the_ solution
 				// (and if unique)
 				if (match == TypeCheck::Match::strictEqual) {
 					perfectMatch = atom;
 					perfectMatchParams = params;
 					perfectMatchTmplParams = tmplparams;
+					perfectMatchIndex = r;
 					++perfectMatchCount;
 				}
 				break;
@@ -108,6 +132,7 @@ bool OverloadedFuncCallResolver::resolve(const std::vector<std::reference_wrappe
 				perfectMatch = &(solutions[bestScoreIndex].get());
 				perfectMatchParams     = &(parameters[bestScoreIndex].first);
 				perfectMatchTmplParams = &(parameters[bestScoreIndex].second);
+				perfectMatchIndex = bestScoreIndex;
 			}
 		}
 		if (1 == perfectMatchCount) {
@@ -115,6 +140,7 @@ bool OverloadedFuncCallResolver::resolve(const std::vector<std::reference_wrappe
 			atom = perfectMatch; // this is _the_ solution !
 			params = perfectMatchParams;
 			tmplparams = perfectMatchTmplParams;
+			solutionIndex = perfectMatchIndex;
 			suitableCount = 1;
 		}
 		else {
@@ -166,8 +192,11 @@ bool OverloadedFuncCallResolver::resolve(const std::vector<std::reference_wrappe
 			// the total number of suitable strictly follows the number of func calls
 			// that could have been instanciatied
 			suitableCount = instanceSuccessCount;
+			solutionIndex = static_cast<uint32_t>(-1);
 		}
 	}
+	if (cacheable and solutionIndex < solutionCount and 1 == suitableCount)
+		compdb.overloads.add(std::move(key), generation, solutionIndex);
 	return (1 == suitableCount);
 }
 
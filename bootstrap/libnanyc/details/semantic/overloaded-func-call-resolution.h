@@ -6,6 +6,7 @@
 #include "details/atom/signature.h"
 #include "details/atom/classdef-table.h"
 #include "func-overload-match.h"
+#include "overload-cache.h"
 #include <memory>
 #include <vector>
 
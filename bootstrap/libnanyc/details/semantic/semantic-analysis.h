@@ -152,6 +152,7 @@ struct Analyzer final {
 
 	void visit(const ir::isa::Operand<ir::isa::Op::allocate>&);
 	void visit(const ir::isa::Operand<ir::isa::Op::assign>&);
+	void visit(const ir::isa::Operand<ir::isa::Op::async>&);
 	void visit(const ir::isa::Operand<ir::isa::Op::blueprint>&);
 	void visit(const ir::isa::Operand<ir::isa::Op::call>&);
 	void visit(const ir::isa::Operand<ir::isa::Op::classdefsizeof>&);
@@ -361,6 +362,13 @@ public:
 	OnScopeFailHandlers onScopeFail;
 	Atom* lastCallWithRaisedError = nullptr;
 
+	struct {
+		//! Result of the next func call, if asynchronous (operator '&')
+		uint32_t lvid = 0;
+		//! The error checking after the func call (jzraise) is not needed
+		bool noErrorChecking = false;
+	} asyncCall;
+
 	struct {
 		uint32_t label = 0;
 		bool compareTo = false;
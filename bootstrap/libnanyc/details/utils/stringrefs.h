@@ -21,6 +21,12 @@ struct StringRefs final {
 	//! Get if a given string is already indexed
 	bool exists(const AnyString& text) const;
 
+	//! Get the unique id of a string already indexed (0 if not found)
+	uint32_t find(const AnyString& text) const;
+
+	//! Get the number of strings (including the empty string at index 0)
+	uint32_t size() const;
+
 	//! Clear the container
 	void clear();
 
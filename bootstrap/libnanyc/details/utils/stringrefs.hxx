@@ -7,6 +7,15 @@ inline bool StringRefs::exists(const AnyString& text) const {
 	return m_index.count(text) != 0;
 }
 
+inline uint32_t StringRefs::find(const AnyString& text) const {
+	auto it = m_index.find(text);
+	return it != m_index.end() ? it->second : 0;
+}
+
+inline uint32_t StringRefs::size() const {
+	return static_cast<uint32_t>(m_storage.size());
+}
+
 inline uint32_t StringRefs::ref(const AnyString& text) {
 	auto it = m_index.find(text);
 	return it != m_index.end() ? it->second : keepString(text);
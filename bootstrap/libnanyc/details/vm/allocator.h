@@ -1,7 +1,9 @@
 #pragma once
 #include <yuni/yuni.h>
 #include "libnanyc.h"
+#include "details/vm/pool.h"
 #include <cassert>
+#include <vector>
 
 namespace ny::vm::memory {
 
@@ -39,7 +41,7 @@ struct NoTracker final {
 	static bool checkObjectSize(const void*, size_t) { return true; }
 	static size_t fetchObjectSize(void*) { return 0; }
 	static bool has(const void*) { return true; }
-	static void releaseAll(nyallocator_t&) {}
+	static void releaseAll() {}
 };
 
 struct TrackPointer final {
@@ -81,22 +83,138 @@ private:
 	uint32_t currentAtomid = 0;
 };
 
+/*!
+** \brief Memory tracker based on a compact open-addressing hash set
+**
+** Same checks than `TrackPointer` (pointer ownership and object size) but
+** without any allocation per tracked pointer. The last validated pointer is
+** cached, since the same object is usually accessed several times in a row.
+*/
+struct FastTracker final {
+	void atomid(uint32_t atomid) {
+		currentAtomid = atomid;
+	}
+
+	uint32_t atomid() const {
+		return currentAtomid;
+	}
+
+	void hold(const void* pointer, size_t size, uint32_t) {
+		if (unlikely((count + 1) * 2 > slots.size()))
+			grow();
+		auto& slot = slots[find(pointer)];
+		if (slot.pointer == nullptr) {
+			slot.pointer = pointer;
+			++count;
+		}
+		slot.objsize = size;
+	}
+
+	void forget(const void* pointer) {
+		if (pointer == lastValid)
+			lastValid = nullptr;
+		if (unlikely(count == 0))
+			return;
+		uint32_t i = find(pointer);
+		if (slots[i].pointer == nullptr)
+			return;
+		// backward shift deletion (no tombstone)
+		const uint32_t mask = static_cast<uint32_t>(slots.size()) - 1;
+		uint32_t j = i;
+		while (true) {
+			j = (j + 1) & mask;
+			if (slots[j].pointer == nullptr)
+				break;
+			uint32_t k = home(slots[j].pointer);
+			bool inplace = (i <= j) ? (i < k and k <= j) : (i < k or k <= j);
+			if (not inplace) {
+				slots[i] = slots[j];
+				i = j;
+			}
+		}
+		slots[i].pointer = nullptr;
+		--count;
+	}
+
+	bool checkObjectSize(const void* pointer, size_t size) const {
+		auto* slot = lookup(pointer);
+		return (likely(slot != nullptr)) and (size == slot->objsize);
+	}
+
+	size_t fetchObjectSize(const void* pointer) const {
+		auto* slot = lookup(pointer);
+		return (likely(slot != nullptr)) ? slot->objsize : 0u;
+	}
+
+	bool has(const void* pointer) const {
+		if (likely(pointer == lastValid))
+			return pointer != nullptr;
+		if (likely(pointer and lookup(pointer))) {
+			lastValid = pointer;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	struct Slot final { const void* pointer; size_t objsize; };
+
+	uint32_t home(const void* pointer) const {
+		auto h = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer)) >> 4) * 0x9E3779B97F4A7C15ull;
+		return static_cast<uint32_t>(h >> 32) & (static_cast<uint32_t>(slots.size()) - 1);
+	}
+
+	//! Index of the slot of a pointer, or of the first free slot
+	uint32_t find(const void* pointer) const {
+		assert(not slots.empty());
+		const uint32_t mask = static_cast<uint32_t>(slots.size()) - 1;
+		uint32_t i = home(pointer);
+		while (slots[i].pointer != nullptr and slots[i].pointer != pointer)
+			i = (i + 1) & mask;
+		return i;
+	}
+
+	const Slot* lookup(const void* pointer) const {
+		if (unlikely(count == 0))
+			return nullptr;
+		auto& slot = slots[find(pointer)];
+		return (slot.pointer != nullptr) ? &slot : nullptr;
+	}
+
+	void grow() {
+		std::vector<Slot> old;
+		old.swap(slots);
+		slots.resize(old.empty() ? 64u : old.size() * 2, Slot{nullptr, 0});
+		for (auto& slot: old) {
+			if (slot.pointer != nullptr)
+				slots[find(slot.pointer)] = slot;
+		}
+	}
+
+	std::vector<Slot> slots;
+	uint32_t count = 0;
+	mutable const void* lastValid = nullptr;
+	uint32_t currentAtomid = 0;
+};
+
 template<class Tracker = NoTracker>
 struct Allocator final {
 	constexpr static const bool fillWithPattern = yuni::debugmode;
 	constexpr static const int fillAlloc = 0xCD;
 	constexpr static const int fillFree  = 0xEF;
 	Tracker tracker;
+	Pool pool;
+
+	explicit Allocator(nyallocator_t& allocator)
+		: pool(allocator) {
+	}
 
 	void* allocate(size_t size, uint32_t lvid) {
-		void* pointer = malloc(size);
-		if (likely(pointer != nullptr)) {
-			tracker.hold(pointer, size, lvid);
-			if (fillWithPattern)
-				memset(pointer, fillAlloc, size);
-			return pointer;
-		}
-		throw std::bad_alloc();
+		void* pointer = pool.allocate(size);
+		tracker.hold(pointer, size, lvid);
+		if (fillWithPattern)
+			memset(pointer, fillAlloc, size);
+		return pointer;
 	}
 
 	void deallocate(void* pointer, size_t size) {
@@ -104,7 +222,7 @@ struct Allocator final {
 			throw PointerMismatch(pointer, size, size, tracker.atomid(), 0);
 		if (fillWithPattern)
 			memset(pointer, fillFree, size);
-		free(pointer);
+		pool.deallocate(pointer, size);
 		tracker.forget(pointer);
 	}
 
@@ -112,14 +230,10 @@ struct Allocator final {
 		if (pointer) {
 			if (unlikely(not tracker.checkObjectSize(pointer, oldsize)))
 				throw PointerMismatch(pointer, oldsize, newsize, tracker.atomid(), lvid);
+			auto* newptr = pool.reallocate(pointer, oldsize, newsize);
 			tracker.forget(pointer);
-			auto* newptr = realloc(pointer, newsize);
-			if (likely(newptr != nullptr)) {
-				tracker.hold(newptr, newsize, lvid);
-				return newptr;
-			}
-			deallocate(pointer, oldsize);
-			throw std::bad_alloc();
+			tracker.hold(newptr, newsize, lvid);
+			return newptr;
 		}
 		return allocate(newsize, lvid);
 	}
@@ -34,4 +34,9 @@ struct ICE final {
 struct InvalidCast final {
 };
 
+struct CallStackOverflow final {
+	CallStackOverflow(uint32_t depth): depth(depth) {}
+	uint32_t depth;
+};
+
 } // ny::vm
@@ -1,21 +1,40 @@
 #include "details/vm/machine.h"
 #include "details/vm/thread.h"
+#include "details/vm/scheduler.h"
 
 namespace ny::vm {
 
 Machine::Machine(const nyvm_opts_t& opts, const ny::Program& program)
 	: opts(opts)
 	, program(program) {
+	if (this->opts.max_call_depth == 0)
+		this->opts.max_call_depth = config::vmMaxCallDepth;
+	if (opts.on_profile_func != nullptr or opts.on_profile_stack != nullptr)
+		profile = std::make_unique<Profile>(static_cast<uint32_t>(program.compdb->functions.size()));
+}
+
+Machine::~Machine() = default;
+
+Scheduler& Machine::scheduler() {
+	std::call_once(jobsInitialized, [&]() {
+		jobs = std::make_unique<Scheduler>(*this);
+	});
+	return *jobs;
 }
 
 int Machine::run() {
+	auto& entrypoint = program.compdb->entrypoint;
+	return run(entrypoint.atomid, entrypoint.instanceid);
+}
+
+int Machine::run(uint32_t atomid, uint32_t instanceid) {
 	int exitstatus = -1;
 	try {
 		ny::vm::Thread thread(*this);
-		uint32_t atomid = program.compdb->entrypoint.atomid;
-		uint32_t instanceid = program.compdb->entrypoint.instanceid;
 		auto r = thread.execute(atomid, instanceid);
 		exitstatus = static_cast<int>(r);
+		if (unlikely(!!profile))
+			profile->report(*this);
 	}
 	catch (...) {
 	}
@@ -1,23 +1,40 @@
 #pragma once
 #include <nanyc/vm.h>
 #include "details/program/program.h"
+#include "details/vm/profiler.h"
+#include <memory>
+#include <mutex>
 
 namespace ny::vm {
 
+struct Scheduler;
+
 struct Machine final {
 	Machine(const nyvm_opts_t&, const ny::Program&);
 	Machine(const Machine&) = delete;
 	Machine(Machine&&) = delete;
 	Machine& operator = (const Machine&) = delete;
 	Machine& operator = (Machine&&) = delete;
+	~Machine();
 
+	//! Run the default entrypoint
 	int run();
+	//! Run a given function
+	int run(uint32_t atomid, uint32_t instanceid);
 	void cout(const AnyString&);
 	void cerr(const AnyString&);
 	void cerrexception(const AnyString&);
+	//! Scheduler for asynchronous func calls (created on first use)
+	Scheduler& scheduler();
 
 	nyvm_opts_t opts;
 	const ny::Program& program;
+	//! Measures of all threads, if the profiling is enabled (see `nyvm_opts_t.on_profile_func`)
+	std::unique_ptr<Profile> profile;
+
+private:
+	std::unique_ptr<Scheduler> jobs;
+	std::once_flag jobsInitialized;
 };
 
 } // namespace ny::vm
@@ -0,0 +1,69 @@
+#include "pool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ny::vm::memory {
+
+Pool::Pool(nyallocator_t& allocator)
+	: allocator(allocator) {
+}
+
+Pool::~Pool() {
+	for (auto& slab: slabs)
+		allocator.deallocate(&allocator, reinterpret_cast<void*>(slab.begin), config::vmPoolSlabSize);
+}
+
+bool Pool::owns(const void* pointer) const {
+	auto p = reinterpret_cast<uintptr_t>(pointer);
+	auto it = std::upper_bound(slabs.begin(), slabs.end(), p, [](uintptr_t p, const Slab& slab) {
+		return p < slab.begin;
+	});
+	return it != slabs.begin() and p < (--it)->end;
+}
+
+Pool::FreeBlock* Pool::refill(uint32_t sizeclass) {
+	assert(freelists[sizeclass] == nullptr);
+	void* memory = allocator.allocate(&allocator, config::vmPoolSlabSize);
+	if (unlikely(memory == nullptr))
+		throw std::bad_alloc();
+	Slab slab;
+	slab.begin = reinterpret_cast<uintptr_t>(memory);
+	slab.end = slab.begin + config::vmPoolSlabSize;
+	auto it = std::upper_bound(slabs.begin(), slabs.end(), slab.begin, [](uintptr_t p, const Slab& slab) {
+		return p < slab.begin;
+	});
+	slabs.insert(it, slab);
+	++stats.slabs;
+	// split the slab into blocks of the same size
+	const uint32_t blocksize = (sizeclass + 1) * granularity;
+	const uint32_t count = config::vmPoolSlabSize / blocksize;
+	auto* base = static_cast<uint8_t*>(memory);
+	FreeBlock* head = nullptr;
+	for (uint32_t i = count; i-- > 0; ) {
+		auto* block = reinterpret_cast<FreeBlock*>(base + i * blocksize);
+		block->next = head;
+		head = block;
+	}
+	freelists[sizeclass] = head;
+	return head;
+}
+
+void* Pool::reallocate(void* pointer, size_t oldsize, size_t newsize) {
+	if (pointer == nullptr)
+		return allocate(newsize);
+	bool pooled = isSmall(oldsize) and owns(pointer);
+	if (not pooled and not isSmall(newsize)) {
+		void* newptr = allocator.reallocate(&allocator, pointer, oldsize, newsize);
+		if (unlikely(newptr == nullptr))
+			throw std::bad_alloc();
+		return newptr;
+	}
+	if (pooled and isSmall(newsize) and sizeClass(oldsize) == sizeClass(newsize))
+		return pointer; // same block
+	void* newptr = allocate(newsize);
+	memcpy(newptr, pointer, std::min(oldsize, newsize));
+	deallocate(pointer, oldsize);
+	return newptr;
+}
+
+} // namespace ny::vm::memory
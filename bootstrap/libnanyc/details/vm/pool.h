@@ -0,0 +1,73 @@
+#pragma once
+#include "libnanyc.h"
+#include "libnanyc-config.h"
+#include <nanyc/allocator.h>
+#include <vector>
+
+namespace ny::vm::memory {
+
+//! Statistics of a memory pool
+struct PoolStatistics final {
+	//! Number of allocations served by the size classes
+	uint64_t allocations = 0;
+	//! Number of allocations forwarded to the allocator (too big for any size class)
+	uint64_t largeAllocations = 0;
+	//! Number of blocks currently in use
+	uint64_t blocksInUse = 0;
+	//! Highest number of blocks in use at the same time
+	uint64_t peakBlocksInUse = 0;
+	//! Number of slabs
+	uint32_t slabs = 0;
+};
+
+/*!
+** \brief Size-class memory pool for small objects, on top of a `nyallocator_t`
+**
+** Small requests are served from slabs split into blocks of the same size (one
+** freelist per size class). Bigger requests and pointers not belonging to any
+** slab (ex: memory adopted from an intrinsic) are forwarded to the allocator.
+** All slabs are released at once when the pool is destroyed.
+*/
+class Pool final {
+public:
+	explicit Pool(nyallocator_t&);
+	Pool(const Pool&) = delete;
+	~Pool();
+
+	//! Allocate a new chunk of memory (throw std::bad_alloc on failure)
+	void* allocate(size_t size);
+	//! Release a chunk of memory previously allocated
+	void deallocate(void* pointer, size_t size);
+	//! Resize a chunk of memory (throw std::bad_alloc on failure, the pointer remains valid)
+	void* reallocate(void* pointer, size_t oldsize, size_t newsize);
+
+	//! Get if a pointer belongs to one of the slabs
+	bool owns(const void* pointer) const;
+	//! Statistics
+	const PoolStatistics& statistics() const;
+
+	Pool& operator = (const Pool&) = delete;
+
+private:
+	static constexpr uint32_t granularity = 16;
+	static constexpr uint32_t classCount = config::vmPoolMaxObjectSize / granularity;
+	static_assert(config::vmPoolMaxObjectSize % granularity == 0, "invalid max object size");
+	static_assert(config::vmPoolSlabSize >= config::vmPoolMaxObjectSize, "invalid slab size");
+
+	struct FreeBlock final { FreeBlock* next; };
+	struct Slab final { uintptr_t begin; uintptr_t end; };
+
+	static bool isSmall(size_t size);
+	static uint32_t sizeClass(size_t size);
+	FreeBlock* refill(uint32_t sizeclass);
+
+	nyallocator_t& allocator;
+	FreeBlock* freelists[classCount] = {};
+	//! All slabs, ordered by address
+	std::vector<Slab> slabs;
+	PoolStatistics stats;
+};
+
+} // namespace ny::vm::memory
+
+#include "pool.hxx"
@@ -0,0 +1,52 @@
+#pragma once
+#include "pool.h"
+#include <cassert>
+#include <new>
+
+namespace ny::vm::memory {
+
+inline bool Pool::isSmall(size_t size) {
+	return size != 0 and size <= config::vmPoolMaxObjectSize;
+}
+
+inline uint32_t Pool::sizeClass(size_t size) {
+	assert(isSmall(size));
+	return static_cast<uint32_t>((size - 1) / granularity);
+}
+
+inline void* Pool::allocate(size_t size) {
+	if (likely(isSmall(size))) {
+		uint32_t sc = sizeClass(size);
+		FreeBlock* block = freelists[sc];
+		if (unlikely(block == nullptr))
+			block = refill(sc);
+		freelists[sc] = block->next;
+		++stats.allocations;
+		if (++stats.blocksInUse > stats.peakBlocksInUse)
+			stats.peakBlocksInUse = stats.blocksInUse;
+		return block;
+	}
+	++stats.largeAllocations;
+	void* pointer = allocator.allocate(&allocator, size);
+	if (unlikely(pointer == nullptr))
+		throw std::bad_alloc();
+	return pointer;
+}
+
+inline void Pool::deallocate(void* pointer, size_t size) {
+	if (likely(isSmall(size) and owns(pointer))) {
+		uint32_t sc = sizeClass(size);
+		auto* block = static_cast<FreeBlock*>(pointer);
+		block->next = freelists[sc];
+		freelists[sc] = block;
+		--stats.blocksInUse;
+		return;
+	}
+	allocator.deallocate(&allocator, pointer, size);
+}
+
+inline const PoolStatistics& Pool::statistics() const {
+	return stats;
+}
+
+} // namespace ny::vm::memory
@@ -0,0 +1,178 @@
+#include "details/vm/profiler.h"
+#include "details/vm/machine.h"
+#include "details/compiler/compdb.h"
+#include "details/ir/isa/data.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace ny::vm {
+
+namespace {
+
+uint64_t childKey(uint32_t node, uint32_t function) {
+	return (static_cast<uint64_t>(node) << 32) | function;
+}
+
+void appendSymbolName(yuni::String& out, const Machine& machine, uint32_t index) {
+	auto& compdb = *machine.program.compdb;
+	auto& func = compdb.functions[index];
+	AnyString name = compdb.cdeftable.atoms.symbolname(func.atomid, func.instanceid);
+	if (unlikely(name.empty())) {
+		out << "<atom:" << func.atomid << '.' << func.instanceid << '>';
+		return;
+	}
+	for (uint32_t i = 0; i != name.size(); ++i)
+		out += (name[i] != ';') ? name[i] : ','; // ';' is the separator of the folded stacks
+}
+
+} // namespace
+
+Profiler::Profiler(Machine& machine)
+	: m_profile(*machine.profile)
+	, m_functions(machine.profile->functions.size())
+	, m_active(machine.profile->functions.size(), 0u)
+	, m_outside(opcodeCount, 0u) {
+	m_nodes.push_back(Node{0, 0, 0, 0});
+	m_frames.reserve(64);
+	m_opcodes = m_outside.data();
+}
+
+Profiler::~Profiler() {
+	// the remaining frames (uncaught exception)
+	while (not m_frames.empty())
+		leave();
+	merge();
+}
+
+uint64_t Profiler::now() {
+	auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Profiler::enter(uint32_t function) {
+	assert(function < m_functions.size());
+	uint32_t parent = m_frames.empty() ? 0u : m_frames.back().node;
+	auto it = m_children.find(childKey(parent, function));
+	uint32_t node;
+	if (it == m_children.end()) {
+		node = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.push_back(Node{parent, function, 0, 0});
+		m_children.emplace(childKey(parent, function), node);
+	}
+	else
+		node = it->second;
+	++m_nodes[node].calls;
+	auto& stats = m_functions[function];
+	++stats.calls;
+	if (unlikely(stats.opcodes.empty()))
+		stats.opcodes.resize(opcodeCount, 0u);
+	m_opcodes = stats.opcodes.data();
+	++m_active[function];
+	m_frames.push_back(Frame{node, now(), 0});
+}
+
+void Profiler::leave() {
+	assert(not m_frames.empty());
+	Frame frame = m_frames.back();
+	m_frames.pop_back();
+	uint64_t elapsed = now() - frame.start;
+	uint64_t exclusive = (elapsed > frame.callees) ? elapsed - frame.callees : 0;
+	auto& node = m_nodes[frame.node];
+	node.exclusive += exclusive;
+	auto& stats = m_functions[node.function];
+	stats.exclusive += exclusive;
+	if (--m_active[node.function] == 0)
+		stats.inclusive += elapsed;
+	if (not m_frames.empty()) {
+		m_frames.back().callees += elapsed;
+		m_opcodes = m_functions[m_nodes[m_frames.back().node].function].opcodes.data();
+	}
+	else
+		m_opcodes = m_outside.data();
+}
+
+void Profiler::merge() {
+	yuni::MutexLocker locker{m_profile.mutex};
+	for (uint32_t i = 0; i != static_cast<uint32_t>(m_functions.size()); ++i) {
+		auto& stats = m_functions[i];
+		if (stats.calls == 0)
+			continue;
+		auto& total = m_profile.functions[i];
+		total.calls += stats.calls;
+		total.inclusive += stats.inclusive;
+		total.exclusive += stats.exclusive;
+		if (total.opcodes.empty())
+			total.opcodes.resize(opcodeCount, 0u);
+		for (uint32_t op = 0; op != opcodeCount; ++op)
+			total.opcodes[op] += stats.opcodes[op];
+	}
+	// the call stacks, identified by their path from the root
+	std::string path;
+	for (uint32_t n = 1; n < static_cast<uint32_t>(m_nodes.size()); ++n) {
+		path.clear();
+		for (uint32_t i = n; i != 0; i = m_nodes[i].parent) {
+			uint32_t function = m_nodes[i].function;
+			path.insert(0, reinterpret_cast<const char*>(&function), sizeof(function));
+		}
+		auto& stack = m_profile.stacks[path];
+		stack.calls += m_nodes[n].calls;
+		stack.exclusive += m_nodes[n].exclusive;
+	}
+}
+
+void Profile::report(const Machine& machine) const {
+	auto& opts = machine.opts;
+	auto& compdb = *machine.program.compdb;
+	yuni::String name;
+	if (opts.on_profile_func) {
+		std::vector<nyvm_profile_opcode_t> opcodes;
+		opcodes.reserve(opcodeCount);
+		for (uint32_t i = 0; i != static_cast<uint32_t>(functions.size()); ++i) {
+			auto& stats = functions[i];
+			if (stats.calls == 0)
+				continue;
+			auto& func = compdb.functions[i];
+			opcodes.clear();
+			for (uint32_t op = 0; op != opcodeCount; ++op) {
+				if (stats.opcodes[op] != 0)
+					opcodes.push_back(nyvm_profile_opcode_t{ir::isa::opname(static_cast<ir::isa::Op>(op)).c_str(), stats.opcodes[op]});
+			}
+			std::sort(opcodes.begin(), opcodes.end(), [](auto& a, auto& b) { return a.count > b.count; });
+			name.clear();
+			appendSymbolName(name, machine, i);
+			nyvm_profile_func_t profile;
+			profile.atomid = func.atomid;
+			profile.instanceid = func.instanceid;
+			profile.name.c_str = name.c_str();
+			profile.name.len = name.size();
+			profile.calls = stats.calls;
+			profile.inclusive_ns = stats.inclusive;
+			profile.exclusive_ns = stats.exclusive;
+			profile.opcodes = opcodes.data();
+			profile.opcode_count = static_cast<uint32_t>(opcodes.size());
+			opts.on_profile_func(opts.userdata, &profile);
+		}
+	}
+	if (opts.on_profile_stack) {
+		for (auto& it: stacks) {
+			auto& path = it.first;
+			name.clear();
+			for (size_t offset = 0; offset < path.size(); offset += sizeof(uint32_t)) {
+				uint32_t function;
+				memcpy(&function, path.data() + offset, sizeof(function));
+				if (offset != 0)
+					name += ';';
+				appendSymbolName(name, machine, function);
+			}
+			nyvm_profile_stack_t profile;
+			profile.folded.c_str = name.c_str();
+			profile.folded.len = name.size();
+			profile.calls = it.second.calls;
+			profile.exclusive_ns = it.second.exclusive;
+			opts.on_profile_stack(opts.userdata, &profile);
+		}
+	}
+}
+
+} // ny::vm
@@ -0,0 +1,115 @@
+#pragma once
+#include "libnanyc.h"
+#include "details/ir/isa/opcodes.h"
+#include <yuni/thread/mutex.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ny::vm {
+
+struct Machine;
+
+//! Number of opcodes in the histograms
+constexpr uint32_t opcodeCount = static_cast<uint32_t>(ir::isa::Op::end) + 1;
+
+/*!
+** \brief Measures of all threads of a machine, reported once the program has run
+**
+** \see nyvm_opts_t.on_profile_func, nyvm_opts_t.on_profile_stack
+*/
+struct Profile final {
+	struct Function final {
+		uint64_t calls = 0;
+		uint64_t inclusive = 0;
+		uint64_t exclusive = 0;
+		//! Executions per opcode (empty if never called)
+		std::vector<uint64_t> opcodes;
+	};
+
+	struct Stack final {
+		uint64_t calls = 0;
+		uint64_t exclusive = 0;
+	};
+
+	explicit Profile(uint32_t functionCount): functions(functionCount) {}
+	Profile(const Profile&) = delete;
+	Profile& operator = (const Profile&) = delete;
+
+	//! Give all measures to the callbacks of the machine
+	void report(const Machine&) const;
+
+	//! Measures per linked function (same indexes than `Compdb::functions`)
+	std::vector<Function> functions;
+	//! Call stacks, from the entrypoint (4 bytes per function index)
+	std::map<std::string, Stack> stacks;
+	yuni::Mutex mutex;
+
+}; // struct Profile
+
+//! No profiling at all
+struct NoProfiler final {
+	static constexpr bool enabled = false;
+	explicit NoProfiler(Machine&) {}
+	static void enter(uint32_t) {}
+	static void leave() {}
+	static void opcode(ir::isa::Op) {}
+};
+
+/*!
+** \brief Profiling of a VM thread
+**
+** Follows the frames of `Stacktrace<true>` with their start time, to build
+** a call tree. All measures are merged into the profile of the machine once
+** the thread has finished its work.
+*/
+struct Profiler final {
+	static constexpr bool enabled = true;
+
+	explicit Profiler(Machine&);
+	Profiler(const Profiler&) = delete;
+	Profiler& operator = (const Profiler&) = delete;
+	~Profiler();
+
+	//! Enter a linked function (index in `Compdb::functions`)
+	void enter(uint32_t function);
+	//! Return from the current function
+	void leave();
+	//! Execution of an opcode by the current function
+	void opcode(ir::isa::Op op) { ++m_opcodes[static_cast<uint32_t>(op)]; }
+
+private:
+	struct Node final {
+		uint32_t parent;
+		uint32_t function;
+		uint64_t calls;
+		uint64_t exclusive;
+	};
+	struct Frame final {
+		uint32_t node;
+		uint64_t start;
+		//! Time spent in the callees
+		uint64_t callees;
+	};
+	static uint64_t now();
+	void merge();
+
+private:
+	Profile& m_profile;
+	std::vector<Profile::Function> m_functions;
+	//! Number of frames per function (to not count the recursive calls twice)
+	std::vector<uint32_t> m_active;
+	//! Call tree (0: root)
+	std::vector<Node> m_nodes;
+	//! {parent node, function} -> node
+	std::unordered_map<uint64_t, uint32_t> m_children;
+	std::vector<Frame> m_frames;
+	//! Histogram of the current function
+	uint64_t* m_opcodes;
+	//! Histogram when no function is running (never reported)
+	std::vector<uint64_t> m_outside;
+
+}; // struct Profiler
+
+} // ny::vm
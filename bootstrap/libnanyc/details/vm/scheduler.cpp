@@ -0,0 +1,164 @@
+#include "details/vm/scheduler.h"
+#include "details/vm/thread.h"
+
+namespace ny::vm {
+
+namespace {
+
+//! Scheduler and queue of the current worker thread, if any
+struct CurrentWorker final {
+	const Scheduler* scheduler = nullptr;
+	uint32_t index = 0;
+};
+
+thread_local CurrentWorker currentWorker;
+
+//! Maximum number of unrelated jobs executed on the native stack of a waiting thread
+constexpr uint32_t maxHelpDepth = 4;
+
+//! Number of unrelated jobs currently executed by the waiting thread
+thread_local uint32_t helpDepth = 0;
+
+uint32_t workerCount(const nyvm_opts_t& opts) {
+	if (opts.async_threads != 0)
+		return opts.async_threads;
+	uint32_t count = std::thread::hardware_concurrency();
+	return (count != 0) ? count : 1u;
+}
+
+} // namespace
+
+Scheduler::Scheduler(Machine& machine)
+	: machine(machine) {
+	uint32_t count = workerCount(machine.opts);
+	queues.reserve(count);
+	for (uint32_t i = 0; i != count; ++i)
+		queues.emplace_back(std::make_unique<Queue>());
+	workers.reserve(count);
+	for (uint32_t i = 0; i != count; ++i)
+		workers.emplace_back([this, i]() { work(i); });
+}
+
+Scheduler::~Scheduler() {
+	{
+		std::lock_guard<std::mutex> lock{sleepMutex};
+		stopping = true;
+	}
+	wakeup.notify_all();
+	for (auto& worker: workers)
+		worker.join();
+}
+
+void Scheduler::spawn(Job& job) {
+	uint32_t index = (currentWorker.scheduler == this)
+		? currentWorker.index
+		: (nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(queues.size()));
+	auto& queue = *queues[index];
+	queued.fetch_add(1, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		queue.jobs.push_back(&job);
+	}
+	{
+		// avoid lost wakeups, the predicate is checked with this lock held
+		std::lock_guard<std::mutex> lock{sleepMutex};
+	}
+	wakeup.notify_one();
+}
+
+void Scheduler::await(Job& job, Thread& thread) {
+	uint32_t index = (currentWorker.scheduler == this) ? currentWorker.index : 0u;
+	if (take(job, index)) {
+		execute(job, thread);
+		return;
+	}
+	// the job is being executed by another thread
+	while (not job.done.load(std::memory_order_acquire)) {
+		Job* other = (helpDepth < maxHelpDepth) ? pop(index) : nullptr;
+		if (other) {
+			++helpDepth;
+			execute(*other, thread);
+			--helpDepth;
+			continue;
+		}
+		std::unique_lock<std::mutex> lock{completionMutex};
+		completion.wait(lock, [&]() { return job.done.load(std::memory_order_acquire); });
+	}
+}
+
+bool Scheduler::take(Job& job, uint32_t index) {
+	uint32_t count = static_cast<uint32_t>(queues.size());
+	for (uint32_t i = 0; i != count; ++i) {
+		auto& queue = *queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		// most likely the last job spawned by this thread
+		for (auto it = queue.jobs.rbegin(); it != queue.jobs.rend(); ++it) {
+			if (*it == &job) {
+				queue.jobs.erase(std::next(it).base());
+				queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+Job* Scheduler::pop(uint32_t index) {
+	if (queued.load(std::memory_order_acquire) == 0)
+		return nullptr;
+	auto& queue = *queues[index];
+	{
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		if (not queue.jobs.empty()) {
+			Job* job = queue.jobs.back();
+			queue.jobs.pop_back();
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+	return steal(index);
+}
+
+Job* Scheduler::steal(uint32_t index) {
+	uint32_t count = static_cast<uint32_t>(queues.size());
+	for (uint32_t i = 1; i < count; ++i) {
+		auto& victim = *queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock{victim.mutex};
+		if (not victim.jobs.empty()) {
+			Job* job = victim.jobs.front();
+			victim.jobs.pop_front();
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void Scheduler::execute(Job& job, Thread& thread) {
+	thread.execute(job);
+	{
+		// avoid lost wakeups, the predicate is checked with this lock held
+		std::lock_guard<std::mutex> lock{completionMutex};
+		job.done.store(true, std::memory_order_release);
+	}
+	completion.notify_all();
+}
+
+void Scheduler::work(uint32_t index) {
+	currentWorker.scheduler = this;
+	currentWorker.index = index;
+	Thread thread{machine};
+	while (true) {
+		Job* job = pop(index);
+		if (job) {
+			execute(*job, thread);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock{sleepMutex};
+		wakeup.wait(lock, [&]() { return stopping or queued.load(std::memory_order_acquire) != 0; });
+		if (stopping)
+			break;
+	}
+}
+
+} // namespace ny::vm
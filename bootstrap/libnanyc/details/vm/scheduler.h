@@ -0,0 +1,84 @@
+#pragma once
+#include "libnanyc.h"
+#include "libnanyc-config.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ny::vm {
+
+struct Machine;
+struct Thread;
+
+//! Asynchronous func call (operator '&')
+struct Job final {
+	uint32_t atomid = 0;
+	uint32_t instanceid = 0;
+	uint32_t paramCount = 0;
+	//! Parameters of the func call (builtin types only)
+	uint64_t parameters[config::maxPushedParameters];
+	//! Returned value, available once done
+	uint64_t result = 0;
+	//! Exception raised by the VM during the execution of the job, if any
+	std::exception_ptr error;
+	std::atomic<bool> done{false};
+};
+
+/*!
+** \brief Work-stealing scheduler for asynchronous func calls
+**
+** Each worker has its own queue of jobs: jobs spawned by a worker are pushed to
+** its own queue and executed in LIFO order (cache friendly), idle workers steal
+** the oldest jobs from the other queues. A thread waiting for a job not started
+** yet executes it directly, thus nested asynchronous calls can not deadlock.
+** Otherwise it executes a few pending jobs meanwhile (see `maxHelpDepth`) and
+** then sleeps until the job is done.
+**
+** Jobs only exchange values of builtin types (see semantic analysis), each
+** job is executed by its own executor with its own memory.
+*/
+struct Scheduler final {
+	explicit Scheduler(Machine&);
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator = (const Scheduler&) = delete;
+	~Scheduler();
+
+	//! Queue a new job (owned by the caller until completion)
+	void spawn(Job&);
+	//! Wait for the completion of a job (the job may be executed by the calling thread)
+	void await(Job&, Thread&);
+
+private:
+	struct Queue final {
+		std::mutex mutex;
+		std::deque<Job*> jobs;
+	};
+
+	void work(uint32_t index);
+	Job* pop(uint32_t index);
+	Job* steal(uint32_t index);
+	//! Remove a job not started yet from the queues
+	bool take(Job&, uint32_t index);
+	void execute(Job&, Thread&);
+
+	Machine& machine;
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	//! Number of jobs not started yet (all queues)
+	std::atomic<uint32_t> queued{0};
+	//! Next queue for jobs spawned by threads not owned by the scheduler
+	std::atomic<uint32_t> nextQueue{0};
+	std::mutex sleepMutex;
+	std::condition_variable wakeup;
+	bool stopping = false;
+	//! Threads waiting for the completion of a job
+	std::mutex completionMutex;
+	std::condition_variable completion;
+};
+
+} // namespace ny::vm
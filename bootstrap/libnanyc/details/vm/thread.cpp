@@ -1,12 +1,18 @@
 #include "dyncall/dyncall.h"
 #include "details/vm/thread.h"
 #include "details/vm/allocator.h"
+#include "details/vm/scheduler.h"
 #include "details/atom/atom.h"
 #include "details/vm/stack.h"
 #include "details/vm/stacktrace.h"
+#include "details/vm/profiler.h"
 #include "details/atom/ctype.h"
 #include "details/vm/exception.h"
+#include "details/compiler/compdb.h"
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 
 #if defined(__GNUC__)
@@ -44,26 +50,79 @@ template<class From> void castMe(ny::vm::Register& reg, ny::CType dest, From fro
 	throw InvalidCast();
 }
 
+/*!
+** \brief Saved state of the caller, stored in the VM stack just before the registers of the callee
+**
+** Func calls do not recurse on the native stack: the caller is suspended and
+** resumed by `Executor::run()` once the callee returns.
+*/
+struct Frame final {
+	Frame* previous;
+	Register* registers;
+	const ir::Bytecode* bytecode;
+	//! Object to release once the callee (a dtor) returns, if any
+	uint64_t* release;
+	uint64_t releaseSize;
+	//! Number of registers allocated in the stack (header + callee)
+	uint32_t size;
+	uint32_t retlvid;
+	//! Offset of the next instruction in the caller (0 if not suspended)
+	uint32_t resume;
+	uint32_t upperLabelID;
+	uint32_t memcheckAtomid;
+	uint32_t registerCount;
+};
+
+static_assert(sizeof(Frame) % sizeof(Register) == 0, "the frames must be aligned on registers");
+
+constexpr uint32_t frameHeaderSize = static_cast<uint32_t>(sizeof(Frame) / sizeof(Register));
+
+/*!
+** \brief Visitor counting the executed opcodes, before executing them (profiling only)
+**
+** The cursor is shared with the executor.
+*/
+template<class E>
+struct ProfiledVisitor final {
+	template<ir::isa::Op O> void visit(const ir::isa::Operand<O>& opr) {
+		executor.profiler.opcode(O);
+		executor.visit(opr);
+	}
+
+	E& executor;
+	const uint8_t**& cursor;
+};
+
+template<class Tracker, class Profiling>
 struct Executor final {
-	using Allocator = ny::vm::memory::Allocator<ny::vm::memory::TrackPointer>;
+	using Allocator = ny::vm::memory::Allocator<Tracker>;
 
 	Register* registers = nullptr; // current registers
 	Register retval;
 	Stack stack;
 	Stacktrace<true> stacktrace;
+	Profiling profiler;
 	uint32_t paramCount = 0;
 	Register parameters[config::maxPushedParameters];
 	uint32_t upperLabelID = 0;
-	std::reference_wrapper<const ir::Sequence> ircode; // current ir sequence
-	DCCallVM* dyncall = nullptr;
+	const ir::Bytecode* bytecode = nullptr; // current code
+	DCCallVM* dyncall = nullptr; // created on first use
 	Allocator allocator;
 	bool unwindRaisedError = false;
 	void* raisedError = nullptr;
 	uint32_t raisedErrorAtomid = 0;
 	const AtomMap& map;
 	const ny::intrinsic::Catalog& intrinsics;
+	const ny::compiler::Compdb& compdb;
+	const ny::compiler::Function* functions; // linked functions
 	ny::vm::Thread& thread;
-	const ir::Instruction** cursor = nullptr;
+	const uint8_t** cursor = nullptr;
+	Frame* frame = nullptr; // current frame
+	uint32_t depth = 0;
+	const uint32_t maxDepth;
+	bool entering = false; // a new func has been entered, the caller is suspended
+	//! Asynchronous func calls not awaited yet
+	std::vector<std::unique_ptr<Job>> jobs;
 
 	struct {
 		#ifndef NDEBUG
@@ -78,24 +137,31 @@ struct Executor final {
 	}
 	dbg;
 
-	Executor(ny::vm::Thread& thread, const ny::ir::Sequence& sequence)
-		: ircode(std::cref(sequence))
-		, dyncall(dcNewCallVM(4096))
+	Executor(ny::vm::Thread& thread)
+		: profiler(thread.machine)
+		, allocator(thread.capi.allocator)
 		, map(thread.machine.program.compdb->cdeftable.atoms)
 		, intrinsics(thread.machine.program.compdb->intrinsics)
-		, thread(thread) {
-		if (unlikely(!dyncall))
-			throw "failed to call dcNewCallVM";
-		dcMode(dyncall, DC_CALL_C_DEFAULT);
+		, compdb(*thread.machine.program.compdb)
+		, functions(thread.machine.program.compdb->functions.data())
+		, thread(thread)
+		, maxDepth(thread.machine.opts.max_call_depth) {
 	}
 
 	~Executor() {
+		// an error may have been raised before reaching 'await'
+		for (auto& job: jobs)
+			thread.machine.scheduler().await(*job, thread);
 		if (dyncall)
 			dcFree(dyncall);
 	}
 
 	NYVM_NOINLINE void destroy(uint64_t* object, uint32_t dtorid);
-	NYVM_NOINLINE void call(uint32_t retlvid, uint32_t atomfunc, uint32_t instanceid);
+	void destroy(uint64_t* object, const ny::compiler::Function& dtor);
+	NYVM_NOINLINE void enter(uint32_t retlvid, uint32_t atomfunc, uint32_t instanceid);
+	void enter(uint32_t retlvid, const ny::compiler::Function& func, uint64_t* release = nullptr);
+	uint32_t leave();
+	void run();
 	inline uint64_t entrypoint(uint32_t atomfunc, uint32_t instanceid);
 
 	void validateLvids(uint32_t lvid) const {
@@ -118,21 +184,18 @@ struct Executor final {
 	template<class O> void printOpcode(const O& opr) const {
 		if (printOpcodes) {
 			std::cout << "== nanyc:vm d:" << dbg.calldepth << " +";
-			std::cout << ircode.get().offsetOf(opr) << "  == ";
-			std::cout << ny::ir::isa::print(ircode.get(), opr, &map) << '\n';
+			std::cout << bytecode->offsetOf(*cursor) << "  == "; // offset of the next instruction
+			std::cout << ny::ir::isa::print(bytecode->sequence(), opr, &map) << '\n';
 		}
 	}
 
 	void returnFromCurrentFunc(uint64_t val = 0) {
 		retval.u64 = val;
-		ircode.get().invalidateCursor(*cursor);
+		bytecode->invalidateCursor(*cursor);
 	}
 
 	void gotoLabel(uint32_t label) {
-		auto& sequence = ircode.get();
-		bool jmpsuccess = (label > upperLabelID)
-			? sequence.jumpToLabelForward(*cursor, label)
-			: sequence.jumpToLabelBackward(*cursor, label);
+		bool jmpsuccess = bytecode->jumpToLabel(*cursor, label, (label > upperLabelID));
 		if (unlikely(not jmpsuccess))
 			throw InvalidLabel(allocator.tracker.atomid(), label);
 		upperLabelID = label; // the labels are strictly ordered
@@ -146,9 +209,26 @@ struct Executor final {
 
 	void visit(const ir::isa::Operand<ir::isa::Op::intrinsic>& opr) {
 		printOpcode(opr);
+		auto& intrinsic = intrinsics[opr.iid];
+		if (likely(intrinsic.trampoline != nullptr)) {
+			assert(paramCount == intrinsic.paramcount);
+			paramCount = 0;
+			intrinsic.trampoline(intrinsic.callback, &thread.capi, parameters, registers[opr.lvid]);
+			return;
+		}
+		callWithDyncall(intrinsic, registers[opr.lvid]);
+	}
+
+	//! Call an intrinsic from its signature known at runtime only
+	NYVM_NOINLINE void callWithDyncall(const ny::intrinsic::Intrinsic& intrinsic, ny::vm::Register& ret) {
+		if (unlikely(!dyncall)) {
+			dyncall = dcNewCallVM(4096);
+			if (unlikely(!dyncall))
+				throw "failed to call dcNewCallVM";
+			dcMode(dyncall, DC_CALL_C_DEFAULT);
+		}
 		dcReset(dyncall);
 		dcArgPointer(dyncall, &thread.capi);
-		auto& intrinsic = intrinsics[opr.iid];
 		for (uint32_t i = 0; i != paramCount; ++i) {
 			auto r = parameters[i];
 			switch (intrinsic.params[i]) {
@@ -169,7 +249,6 @@ struct Executor final {
 			}
 		}
 		paramCount = 0;
-		ny::vm::Register& ret = registers[opr.lvid];
 		auto* cb = (DCpointer) intrinsic.callback;
 		switch (intrinsic.rettype) {
 			case CType::t_u64:  ret.u64 = static_cast<uint64_t>(dcCallLongLong(dyncall, cb)); break;
@@ -422,7 +501,7 @@ struct Executor final {
 	void visit(const ir::isa::Operand<ir::isa::Op::storeText>& opr) {
 		printOpcode(opr);
 		validateLvids(opr);
-		auto cstr = ircode.get().stringrefs[opr.text].c_str();
+		auto cstr = bytecode->sequence().stringrefs[opr.text].c_str();
 		registers[opr.lvid].u64 = reinterpret_cast<uint64_t>(cstr);
 	}
 
@@ -442,7 +521,43 @@ struct Executor final {
 	void visit(const ir::isa::Operand<ir::isa::Op::call>& opr) {
 		validateLvids(opr);
 		printOpcode(opr);
-		call(opr.lvid, opr.ptr2func, opr.instanceid);
+		enter(opr.lvid, opr.ptr2func, opr.instanceid);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::fcall>& opr) {
+		validateLvids(opr);
+		printOpcode(opr);
+		enter(opr.lvid, functions[opr.func]);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::spawn>& opr) {
+		validateLvids(opr);
+		printOpcode(opr);
+		auto job = std::make_unique<Job>();
+		job->atomid = opr.ptr2func;
+		job->instanceid = opr.instanceid;
+		job->paramCount = paramCount;
+		for (uint32_t i = 0; i != paramCount; ++i)
+			job->parameters[i] = parameters[i].u64;
+		paramCount = 0;
+		registers[opr.lvid].u64 = reinterpret_cast<uint64_t>(job.get());
+		thread.machine.scheduler().spawn(*job);
+		jobs.emplace_back(std::move(job));
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::await>& opr) {
+		validateLvids(opr);
+		printOpcode(opr);
+		auto* job = reinterpret_cast<Job*>(registers[opr.lvid].u64);
+		thread.machine.scheduler().await(*job, thread);
+		registers[opr.lvid].u64 = job->result;
+		std::exception_ptr error = job->error;
+		auto it = std::find_if(jobs.begin(), jobs.end(), [&](auto& ptr) { return ptr.get() == job; });
+		assert(it != jobs.end());
+		std::swap(*it, jobs.back());
+		jobs.pop_back();
+		if (unlikely(error))
+			std::rethrow_exception(error);
 	}
 
 	void visit(const ir::isa::Operand<ir::isa::Op::fieldset>& opr) {
@@ -483,6 +598,55 @@ struct Executor final {
 		}
 	}
 
+	void visit(const ir::isa::Operand<ir::isa::Op::addimm>& opr) {
+		printOpcode(opr);
+		validateLvids(opr);
+		registers[opr.lvid].u64 = registers[opr.lhs].u64 + opr.value;
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::subimm>& opr) {
+		printOpcode(opr);
+		validateLvids(opr);
+		registers[opr.lvid].u64 = registers[opr.lhs].u64 - opr.value;
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzeq>& opr) {
+		if (not (registers[opr.lhs].u64 == registers[opr.rhs].u64))
+			gotoLabel(opr.label);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzneq>& opr) {
+		if (not (registers[opr.lhs].u64 != registers[opr.rhs].u64))
+			gotoLabel(opr.label);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzlt>& opr) {
+		if (not (registers[opr.lhs].u64 < registers[opr.rhs].u64))
+			gotoLabel(opr.label);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzilt>& opr) {
+		if (not (registers[opr.lhs].i64 < registers[opr.rhs].i64))
+			gotoLabel(opr.label);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzlte>& opr) {
+		if (not (registers[opr.lhs].u64 <= registers[opr.rhs].u64))
+			gotoLabel(opr.label);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzilte>& opr) {
+		if (not (registers[opr.lhs].i64 <= registers[opr.rhs].i64))
+			gotoLabel(opr.label);
+	}
+
+	void visit(const ir::isa::Operand<ir::isa::Op::jzfield>& opr) {
+		uint64_t* object = reinterpret_cast<uint64_t*>(registers[opr.self].u64);
+		allocator.validate(object, opr.self);
+		if (object[1 + opr.var] == 0)
+			gotoLabel(opr.label);
+	}
+
 	void visit(const ir::isa::Operand<ir::isa::Op::ref>& opr) {
 		printOpcode(opr);
 		validateLvids(opr);
@@ -496,13 +660,27 @@ struct Executor final {
 		validateLvids(opr);
 		uint64_t* object = reinterpret_cast<uint64_t*>(registers[opr.lvid].u64);
 		allocator.validate(object, opr.lvid);
-		if (0 == --(object[0])) // -unref
-			destroy(object, opr.atomid);
+		if (0 == --(object[0])) { // -unref
+			if (likely(opr.dtor != (uint32_t) -1))
+				destroy(object, functions[opr.dtor]);
+			else
+				destroy(object, opr.atomid);
+		}
 	}
 
-	void visit(const ir::isa::Operand<ir::isa::Op::stackalloc>& opr) {
+	void visit(const ir::isa::Operand<ir::isa::Op::unrefrange>& opr) {
 		printOpcode(opr);
 		validateLvids(opr);
+		// the dtor does nothing, the objects can be released without suspending the caller
+		auto& dtor = functions[opr.dtor];
+		assert(dtor.trivial);
+		for (uint32_t i = opr.count; i-- != 0; ) {
+			validateLvids(opr.lvid + i);
+			uint64_t* object = reinterpret_cast<uint64_t*>(registers[opr.lvid + i].u64);
+			allocator.validate(object, opr.lvid + i);
+			if (0 == --(object[0])) // -unref
+				allocator.deallocate(object, static_cast<size_t>(dtor.objectsize));
+		}
 	}
 
 	void visit(const ir::isa::Operand<ir::isa::Op::memalloc>& opr) {
@@ -660,7 +838,12 @@ struct Executor final {
 				atom->findFuncAtom(dtor, "^dispose");
 				if (unlikely(dtor == nullptr))
 					throw InvalidDtor(*atom);
-				destroy(reinterpret_cast<uint64_t*>(raisedError), dtor->atomid);
+				auto* error = reinterpret_cast<uint64_t*>(raisedError);
+				raisedError = nullptr;
+				unwindRaisedError = false;
+				gotoLabel(opr.label);
+				destroy(error, dtor->atomid); // resumed after the label
+				return;
 			}
 			raisedError = nullptr;
 			unwindRaisedError = false;
@@ -682,11 +865,6 @@ struct Executor final {
 		}
 	}
 
-	void visit(const ir::isa::Operand<ir::isa::Op::comment>&) {}
-	void visit(const ir::isa::Operand<ir::isa::Op::scope>&) {}
-	void visit(const ir::isa::Operand<ir::isa::Op::end>&) {}
-	void visit(const ir::isa::Operand<ir::isa::Op::nop>&) {}
-
 	template<ir::isa::Op O> void visit(const ir::isa::Operand<O>& opr) {
 		printOpcode(opr);
 		(void) opr;
@@ -694,76 +872,167 @@ struct Executor final {
 	}
 };
 
-void Executor::destroy(uint64_t* object, uint32_t dtorid) {
-	auto& dtor = *map.findAtom(dtorid);
-	auto* classobject = dtor.parent;
-	assert(classobject != nullptr);
-	uint64_t classsizeof = classobject->runtimeSizeof();
-	classsizeof += config::extraObjectSize;
+template<class Tracker, class Profiling>
+void Executor<Tracker, Profiling>::destroy(uint64_t* object, uint32_t dtorid) {
+	// dtor not resolved by the link step
+	auto* func = compdb.findFunction(dtorid, 0); // always only one version of the dtor
+	if (unlikely(func == nullptr))
+		throw ICE(__LINE__, "dtor not linked");
+	assert(func->objectsize != 0);
+	destroy(object, *func);
+}
+
+template<class Tracker, class Profiling>
+inline void Executor<Tracker, Profiling>::destroy(uint64_t* object, const ny::compiler::Function& dtor) {
 	paramCount = 1;
 	parameters[0].u64 = reinterpret_cast<uint64_t>(object); // self
-	uint32_t instanceid = 0; // always only one version of the dtor
-	call(0, dtor.atomid, instanceid);
-	allocator.deallocate(object, static_cast<size_t>(classsizeof));
+	enter(0, dtor, object); // the object is released once the dtor returns
 }
 
-inline uint64_t Executor::entrypoint(uint32_t atomfunc, uint32_t instanceid) {
+template<class Tracker, class Profiling>
+inline uint64_t Executor<Tracker, Profiling>::entrypoint(uint32_t atomfunc, uint32_t instanceid) {
 	constexpr uint32_t retlvid = 1;
 	dbg.registerCount(2);
 	Register localregisters[2];
 	registers = &localregisters[0];
-	call(retlvid, atomfunc, instanceid);
+	enter(retlvid, atomfunc, instanceid);
+	run();
 	return localregisters[retlvid].u64;
 }
 
-void Executor::call(uint32_t retlvid, uint32_t atomfunc, uint32_t instanceid) {
+template<class Tracker, class Profiling>
+void Executor<Tracker, Profiling>::enter(uint32_t retlvid, uint32_t atomfunc, uint32_t instanceid) {
+	// not resolved by the link step (entrypoint, 'call' opcode...)
+	auto* func = compdb.findFunction(atomfunc, instanceid);
+	if (unlikely(func == nullptr))
+		throw ICE(__LINE__, "func not linked");
+	enter(retlvid, *func);
+}
+
+template<class Tracker, class Profiling>
+inline void Executor<Tracker, Profiling>::enter(uint32_t retlvid, const ny::compiler::Function& func, uint64_t* release) {
 	assert(retlvid == 0 or retlvid < dbg.registerCount());
+	assert(func.framesize < 1024 * 1024);
+	if (unlikely(depth == maxDepth))
+		throw CallStackOverflow(maxDepth);
+	++depth;
 	if (printOpcodes) {
 		std::cout << "== ny:vm >>  registers before call\n";
 		for (uint32_t r = 0; r != dbg.registerCount(); ++r)
 			std::cout << "== ny:vm >>     reg %" << r << " = " << registers[r].u64 << "\n";
-		std::cout << "== ny:vm >> " << (++dbg.calldepth) << " entering func atom:" << atomfunc;
-		std::cout << ", instance: " << instanceid << '\n';
+		std::cout << "== ny:vm >> " << (++dbg.calldepth) << " entering func atom:" << func.atomid;
+		std::cout << ", instance: " << func.instanceid << '\n';
 	}
+	stacktrace.push(func.atomid, func.instanceid);
+	profiler.enter(static_cast<uint32_t>(&func - functions));
 	// save the current stack frame
-	auto* storestackptr = registers;
-	auto storeircode = std::cref(ircode);
-	auto* storecursor = cursor;
-	auto storestckfrmsize = dbg.registerCount();
-	auto labelid = upperLabelID;
-	uint32_t memcheckPreviousAtomid = allocator.tracker.atomid();
-	stacktrace.push(atomfunc, instanceid);
-	// call
-	Register ret = ([&](const ir::Sequence& callee) {
-		retval.u64 = 0;
-		const uint32_t framesize = callee.at<ir::isa::Op::stacksize>(0).add;
-		assert(framesize < 1024 * 1024);
-		dbg.registerCount(framesize);
-		assert(callee.at<ir::isa::Op::stacksize>(0).opcode == (uint32_t) ir::isa::Op::stacksize);
-		registers = stack.push(framesize);
-		registers[0].u64 = 0;
-		ircode = std::cref(callee);
-		upperLabelID = 0;
-		for (uint32_t i = 0; i != paramCount; ++i)
-			registers[i + 2].u64 = parameters[i].u64; // 2-based
-		paramCount = 0;
-		callee.each(*this, 1); // offset: 1, avoid blueprint pragma
-		stack.pop(framesize);
-		return retval;
-	})(map.ircode(atomfunc, instanceid));
+	uint32_t size = frameHeaderSize + func.framesize;
+	auto* newframe = reinterpret_cast<Frame*>(stack.push(size));
+	newframe->previous = frame;
+	newframe->registers = registers;
+	newframe->bytecode = bytecode;
+	newframe->release = release;
+	newframe->releaseSize = func.objectsize;
+	newframe->size = size;
+	newframe->retlvid = retlvid;
+	newframe->resume = 0;
+	newframe->upperLabelID = upperLabelID;
+	newframe->memcheckAtomid = allocator.tracker.atomid();
+	newframe->registerCount = dbg.registerCount();
+	if (cursor != nullptr) {
+		// suspend the caller, resumed by `run()`
+		newframe->resume = bytecode->offsetOf(*cursor); // already on the next instruction
+		bytecode->invalidateCursor(*cursor);
+	}
+	frame = newframe;
+	entering = true;
+	// the callee
+	registers = reinterpret_cast<Register*>(newframe) + frameHeaderSize;
+	registers[0].u64 = 0;
+	for (uint32_t i = 0; i != paramCount; ++i)
+		registers[i + 2].u64 = parameters[i].u64; // 2-based
+	paramCount = 0;
+	bytecode = func.bytecode;
+	upperLabelID = 0;
+	retval.u64 = 0;
+	dbg.registerCount(func.framesize);
+}
+
+template<class Tracker, class Profiling>
+inline uint32_t Executor<Tracker, Profiling>::leave() {
 	// restore the previous stack frame and store the result of the call
-	upperLabelID = labelid;
-	registers = storestackptr;
-	registers[retlvid] = ret;
-	ircode = std::cref(storeircode);
-	cursor = storecursor;
-	dbg.registerCount(storestckfrmsize);
+	auto* current = frame;
+	Register ret = retval;
+	uint32_t retlvid = current->retlvid;
+	uint32_t resume = current->resume;
+	uint64_t* release = current->release;
+	uint64_t releaseSize = current->releaseSize;
+	frame = current->previous;
+	registers = current->registers;
+	bytecode = current->bytecode;
+	upperLabelID = current->upperLabelID;
+	allocator.tracker.atomid(current->memcheckAtomid);
+	dbg.registerCount(current->registerCount);
+	stack.pop(current->size); // 'current' is not valid anymore
 	stacktrace.pop();
-	allocator.tracker.atomid(memcheckPreviousAtomid);
+	profiler.leave();
+	--depth;
+	registers[retlvid] = ret;
+	if (release != nullptr)
+		allocator.deallocate(release, static_cast<size_t>(releaseSize));
 	if (printOpcodes) {
 		std::cout << "== ny:vm << " << dbg.calldepth << " returned from func call\n";
 		--dbg.calldepth;
 	}
+	return resume;
+}
+
+template<class Tracker, class Profiling>
+void Executor<Tracker, Profiling>::run() {
+	// calls and returns are iterations, not native recursions
+	uint32_t offset = 0;
+	while (frame != nullptr) {
+		entering = false;
+		if constexpr (Profiling::enabled) {
+			ProfiledVisitor<Executor> visitor{*this, cursor};
+			bytecode->each(visitor, offset);
+		}
+		else
+			bytecode->each(*this, offset);
+		offset = entering ? 0 : leave();
+	}
+	cursor = nullptr;
+}
+
+template<class Tracker, class Profiling>
+void runEntrypoint(ny::vm::Thread& thread, uint32_t atomid, uint32_t instanceid) {
+	Executor<Tracker, Profiling> executor{thread};
+	executor.stacktrace.push(atomid, instanceid);
+	executor.entrypoint(atomid, instanceid);
+}
+
+template<class Tracker>
+void executeEntrypoint(ny::vm::Thread& thread, uint32_t atomid, uint32_t instanceid) {
+	if (unlikely(!!thread.machine.profile))
+		return runEntrypoint<Tracker, Profiler>(thread, atomid, instanceid);
+	runEntrypoint<Tracker, NoProfiler>(thread, atomid, instanceid);
+}
+
+template<class Tracker, class Profiling>
+void runJob(ny::vm::Thread& thread, Job& job) {
+	Executor<Tracker, Profiling> executor{thread};
+	executor.stacktrace.push(job.atomid, job.instanceid);
+	executor.paramCount = job.paramCount;
+	for (uint32_t i = 0; i != job.paramCount; ++i)
+		executor.parameters[i].u64 = job.parameters[i];
+	job.result = executor.entrypoint(job.atomid, job.instanceid);
+}
+
+template<class Tracker>
+void executeJob(ny::vm::Thread& thread, Job& job) {
+	if (unlikely(!!thread.machine.profile))
+		return runJob<Tracker, Profiler>(thread, job);
+	runJob<Tracker, NoProfiler>(thread, job);
 }
 
 } // namespace
@@ -784,11 +1053,19 @@ Thread::Thread(Machine& machine)
 
 uint64_t Thread::execute(uint32_t atomid, uint32_t instanceid) {
 	try {
-		auto& map = machine.program.compdb->cdeftable.atoms;
-		auto& ircode = map.ircode(atomid, instanceid);
-		Executor executor{*this, ircode};
-		executor.stacktrace.push(atomid, instanceid);
-		executor.entrypoint(atomid, instanceid);
+		switch (machine.opts.memcheck) {
+			case nyvm_memcheck_none:
+				executeEntrypoint<memory::NoTracker>(*this, atomid, instanceid);
+				break;
+			case nyvm_memcheck_full:
+				executeEntrypoint<memory::TrackPointer>(*this, atomid, instanceid);
+				break;
+			case nyvm_memcheck_default:
+			case nyvm_memcheck_fast:
+			default:
+				executeEntrypoint<memory::FastTracker>(*this, atomid, instanceid);
+				break;
+		}
 		return 0;
 	}
 	catch (const InvalidLabel& e) {
@@ -809,6 +1086,9 @@ uint64_t Thread::execute(uint32_t atomid, uint32_t instanceid) {
 	catch (const InvalidCast&) {
 		machine.cerrexception("invalid cast");
 	}
+	catch (const CallStackOverflow& e) {
+		machine.cerrexception(yuni::String("call stack overflow (max depth: ") << e.depth << ')');
+	}
 	catch (const ny::vm::memory::UnknownPointer& e) {
 		yuni::String msg("unknown pointer ");
 		msg << e.pointer << " atomid:" << e.atomid << " %" << e.lvid;
@@ -832,4 +1112,26 @@ uint64_t Thread::execute(uint32_t atomid, uint32_t instanceid) {
 	return 120;
 }
 
+void Thread::execute(Job& job) {
+	try {
+		switch (machine.opts.memcheck) {
+			case nyvm_memcheck_none:
+				executeJob<memory::NoTracker>(*this, job);
+				break;
+			case nyvm_memcheck_full:
+				executeJob<memory::TrackPointer>(*this, job);
+				break;
+			case nyvm_memcheck_default:
+			case nyvm_memcheck_fast:
+			default:
+				executeJob<memory::FastTracker>(*this, job);
+				break;
+		}
+	}
+	catch (...) {
+		// reported by the thread waiting for the result
+		job.error = std::current_exception();
+	}
+}
+
 } // namespace ny::vm
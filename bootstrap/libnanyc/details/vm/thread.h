@@ -5,6 +5,8 @@
 
 namespace ny::vm {
 
+struct Job;
+
 struct Thread final {
 	Thread(Machine&);
 	Thread(const Thread&) = delete;
@@ -13,6 +15,8 @@ struct Thread final {
 	Thread& operator = (Thread&&) = delete;
 
 	uint64_t execute(uint32_t atomid, uint32_t instanceid);
+	//! Execute an asynchronous func call (the exception raised by the VM, if any, is kept by the job)
+	void execute(Job&);
 
 	nyvmthread_t capi;
 	ny::vm::IO io;
@@ -27,6 +27,121 @@ typedef struct nysourcelist_opts_t {
 }
 nysourcelist_opts_t;
 
+typedef struct nyentrypointlist_opts_t {
+	nyanystr_t* items;
+	uint32_t count;
+}
+nyentrypointlist_opts_t;
+
+struct nyvmthread_t;
+
+/*! Builtin types, for values exchanged with host intrinsics */
+typedef enum nytype_t {
+	nyt_void,
+	nyt_any, /* invalid for host intrinsics */
+	nyt_ptr,
+	nyt_bool,
+	nyt_u8,
+	nyt_u16,
+	nyt_u32,
+	nyt_u64,
+	nyt_i8,
+	nyt_i16,
+	nyt_i32,
+	nyt_i64,
+	nyt_f32,
+	nyt_f64,
+}
+nytype_t;
+
+/*! Value exchanged with host intrinsics (f32 values are stored as f64, pointers as u64) */
+typedef union nyvalue_t {
+	uint64_t u64;
+	int64_t i64;
+	double f64;
+}
+nyvalue_t;
+
+/*!
+** \brief Native function provided by the host, callable from nanyc code (`!!name(...)`)
+**
+** The parameters are read directly from the registers of the VM, without any
+** marshalling. The callback may be called concurrently from several threads.
+*/
+typedef struct nyintrinsic_t {
+	/*! Name of the intrinsic (ex: "myapp.compute") */
+	nyanystr_t name;
+	void (*callback)(struct nyvmthread_t*, const nyvalue_t* params, nyvalue_t* ret);
+	/*! Type of the returned value */
+	nytype_t rettype;
+	/*! Types of the parameters */
+	const nytype_t* params;
+	uint32_t paramcount;
+}
+nyintrinsic_t;
+
+/*! Optimization level of the instanciated code */
+typedef enum nyoptimize_t {
+	/*! Default level ('full') */
+	nyoptimize_default,
+	/*! No optimization at all (the code is kept as generated, easier to debug) */
+	nyoptimize_none,
+	/*! Local optimizations only: constant folding, dead code elimination, superinstructions */
+	nyoptimize_basic,
+	/*! All optimizations, including inlining and the elision of allocations and refcounts */
+	nyoptimize_full,
+}
+nyoptimize_t;
+
+typedef struct nyintrinsiclist_opts_t {
+	nyintrinsic_t* items;
+	uint32_t count;
+}
+nyintrinsiclist_opts_t;
+
+/*! Phases of the compilation, for profiling */
+typedef enum nycompile_phase_t {
+	/*! Parsing of a source file */
+	nycompile_phase_parse,
+	/*! Normalization of the AST of a source file */
+	nycompile_phase_normalize,
+	/*! Generation of the IR of a source file */
+	nycompile_phase_ast2ir,
+	/*! Loading of the IR of a source file from the cache (instead of parse/normalize/ast2ir) */
+	nycompile_phase_cache,
+	/*! Mapping of the atoms declared by a source file */
+	nycompile_phase_attach,
+	/*! Resolution of the parameter types of all atoms (typedefs) */
+	nycompile_phase_typedefs,
+	/*! Instanciation of an atom (all its instances) */
+	nycompile_phase_instanciate,
+	/*! Link of all instanciated functions */
+	nycompile_phase_link,
+	/*! The whole compilation */
+	nycompile_phase_total,
+}
+nycompile_phase_t;
+
+/*! Measure of a compilation phase, for a source file or an atom */
+typedef struct nycompile_profile_t {
+	nycompile_phase_t phase;
+	/*! Filename of the source, name of the atom (instanciation), empty otherwise */
+	nyanystr_t name;
+	/*! Atom id (instanciation only) */
+	uint32_t atomid;
+	/*! Number of measures (instances for an atom) */
+	uint32_t count;
+	/*! Elapsed time, in nanoseconds */
+	uint64_t wall_ns;
+	/*! CPU time of the thread, in nanoseconds (0 if not available) */
+	uint64_t cpu_ns;
+	/*! Elapsed time without the nested instanciations, in nanoseconds */
+	uint64_t self_ns;
+	/*! Number of memory allocations (0 if `allocation_count` is not provided) */
+	uint64_t allocations;
+}
+nycompile_profile_t;
+
 
 
 
@@ -46,6 +161,23 @@ typedef struct nycompile_opts_t {
 	void (*on_file_eaccess)(void*, const nysource_opts_t*);
 	void (*on_unittest)(void* userdata, const char* mod, uint32_t mlen, const char* name, uint32_t nlen);
 	void (*on_report)(void* userdata, const nyreport_t*);
+	/*! Directory for caching the IR of each source file (disabled if empty) */
+	nyanystr_t cache_path;
+	/*! Number of threads for parsing the source files (0: auto) */
+	uint32_t jobs;
+	/*! Additional entrypoints, which can be run via `nyvm_run_entrypoint_by_name()` */
+	nyentrypointlist_opts_t entrypoints;
+	/*! Native functions provided by the host */
+	nyintrinsiclist_opts_t intrinsics;
+	/*! Optimization level of the instanciated code */
+	nyoptimize_t optimize;
+	/*!
+	** Profiling of the compiler (disabled if null), called for each measure
+	** once the compilation is over (before `on_build_stop`)
+	*/
+	void (*on_profile)(void* userdata, const nycompile_profile_t*);
+	/*! Number of memory allocations performed so far by the calling thread, for profiling [optional] */
+	uint64_t (*allocation_count)(void* userdata);
 }
 nycompile_opts_t;
 
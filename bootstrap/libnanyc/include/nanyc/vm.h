@@ -21,6 +21,56 @@ extern "C" {
 typedef struct nyvmthread_t nyvmthread_t;
 typedef struct nyvm_opts_t nyvm_opts_t;
 
+/*! Memory checking level */
+typedef enum nyvm_memcheck_t {
+	/*! Default level, 'fast' (thus zero-initialized options are safe) */
+	nyvm_memcheck_default,
+	/*! No check at all, for trusted programs only (invalid pointers are not detected) */
+	nyvm_memcheck_none,
+	/*! All pointers and object sizes are checked */
+	nyvm_memcheck_fast,
+	/*! Same as 'fast', with additional information for each allocation (debug) */
+	nyvm_memcheck_full,
+}
+nyvm_memcheck_t;
+
+/*! Number of executions of an opcode, for profiling */
+typedef struct nyvm_profile_opcode_t {
+	/*! Name of the opcode (ex: "add") */
+	const char* name;
+	uint64_t count;
+}
+nyvm_profile_opcode_t;
+
+/*! Measures of a function, for profiling */
+typedef struct nyvm_profile_func_t {
+	uint32_t atomid;
+	uint32_t instanceid;
+	/*! Human readable name of the function */
+	nyanystr_t name;
+	/*! Number of calls */
+	uint64_t calls;
+	/*! Elapsed time in the function, with its callees, in nanoseconds (recursive calls counted once) */
+	uint64_t inclusive_ns;
+	/*! Elapsed time in the function only, in nanoseconds */
+	uint64_t exclusive_ns;
+	/*! Executed opcodes, the most frequent first */
+	const nyvm_profile_opcode_t* opcodes;
+	uint32_t opcode_count;
+}
+nyvm_profile_func_t;
+
+/*! Call stack, for profiling (flamegraphs) */
+typedef struct nyvm_profile_stack_t {
+	/*! Names of the functions from the entrypoint, separated by ';' (folded stack) */
+	nyanystr_t folded;
+	/*! Number of calls of the last function from this stack */
+	uint64_t calls;
+	/*! Elapsed time in the last function only, in nanoseconds */
+	uint64_t exclusive_ns;
+}
+nyvm_profile_stack_t;
+
 struct nyvmthread_t {
 	void* internal;
 	nyio_adapter_t* (*io_resolve)(nyvmthread_t*, nyanystr_t* relpath, const nyanystr_t* path);
@@ -46,6 +96,18 @@ struct nyvm_opts_t {
 	nyallocator_t allocator;
 	nyconsole_t cout;
 	nyconsole_t cerr;
+	/*! Memory checking level */
+	nyvm_memcheck_t memcheck;
+	/*! Maximum depth of nested func calls per thread (0: default) */
+	uint32_t max_call_depth;
+	/*! Number of threads executing asynchronous func calls, started on first use (0: one per core) */
+	uint32_t async_threads;
+	/*!
+	** Profiling of the program (disabled if both are null), called for each
+	** function and each call stack once the program has run
+	*/
+	void (*on_profile_func)(void* userdata, const nyvm_profile_func_t*);
+	void (*on_profile_stack)(void* userdata, const nyvm_profile_stack_t*);
 };
 
 //! Init VM options with default values
@@ -53,10 +115,22 @@ NY_EXPORT void nyvm_opts_init_defaults(nyvm_opts_t*);
 
 /*!
 ** \brief Run the program
+**
+** The program is not modified and can be run concurrently from several threads.
 ** \return nyfalse if any internal error occured during runtime
 */
 NY_EXPORT nybool_t nyvm_run_entrypoint(const nyvm_opts_t*, const nyprogram_t*);
 
+/*!
+** \brief Run an entrypoint of the program, from its name
+**
+** The entrypoint must have been given at compile time (`nycompile_opts_t.entrypoint`
+** or `nycompile_opts_t.entrypoints`). The program is not modified and can be
+** run concurrently from several threads.
+** \return nyfalse if the entrypoint is unknown or if any internal error occured during runtime
+*/
+NY_EXPORT nybool_t nyvm_run_entrypoint_by_name(const nyvm_opts_t*, const nyprogram_t*, const char* name, size_t len);
+
 
 #ifdef __cplusplus
 }
@@ -11,6 +11,11 @@ extern "C" void nyvm_opts_init_defaults(nyvm_opts_t* opts) {
 		nyallocator_init_from_malloc(&opts->allocator);
 		nyconsole_init_from_stdout(&opts->cout);
 		nyconsole_init_from_stderr(&opts->cerr);
+		opts->memcheck = nyvm_memcheck_fast;
+		opts->max_call_depth = ny::config::vmMaxCallDepth;
+		opts->async_threads = 0;
+		opts->on_profile_func = nullptr;
+		opts->on_profile_stack = nullptr;
 	}
 }
 
@@ -27,3 +32,21 @@ nybool_t nyvm_run_entrypoint(const nyvm_opts_t* opts, const nyprogram_t* program
 	}
 	return nyfalse;
 }
+
+nybool_t nyvm_run_entrypoint_by_name(const nyvm_opts_t* opts, const nyprogram_t* program, const char* name, size_t len) {
+	if (unlikely(!opts or !program or !name or len == 0 or len > 1024 * 1024))
+		return nyfalse;
+	try {
+		auto* prgm = reinterpret_cast<const ny::Program*>(program);
+		auto& entrypoints = prgm->compdb->entrypoints;
+		auto it = entrypoints.find(AnyString{name, static_cast<uint32_t>(len)});
+		if (unlikely(it == entrypoints.end()))
+			return nyfalse;
+		auto machine = std::make_unique<ny::vm::Machine>(*opts, *prgm);
+		int exitstatus = machine->run(it->second.atomid, it->second.instanceid);
+		return (exitstatus == 0) ? nytrue : nyfalse;
+	}
+	catch (...) {
+	}
+	return nyfalse;
+}
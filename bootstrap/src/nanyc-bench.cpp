@@ -0,0 +1,413 @@
+#include <nanyc/library.h>
+#include <nanyc/program.h>
+#include <nanyc/vm.h>
+#include <yuni/core/getopt.h>
+#include <yuni/core/string.h>
+#include <yuni/io/directory.h>
+#include <yuni/io/directory/info.h>
+#include <yuni/io/filename-manipulation.h>
+#include <yuni/io/io.h>
+#include <yuni/yuni.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "libnanyc.h"
+
+
+namespace ny {
+namespace bench {
+namespace {
+
+struct Stats final {
+	uint64_t min = 0;
+	uint64_t max = 0;
+	uint64_t median = 0;
+	double mean = 0.;
+	double stddev = 0.;
+};
+
+struct Result final {
+	//! 'compile' or 'run'
+	const char* kind;
+	yuni::String name;
+	bool success = false;
+	//! Duration of each measured run, in nanoseconds
+	std::vector<uint64_t> samples;
+	Stats stats;
+};
+
+struct App final {
+	App();
+	App(const App&) = delete;
+
+	//! Add all benchmarks (files, folders and the synthetic sources)
+	void importFilenames(const std::vector<yuni::String>&);
+	//! Run all benchmarks
+	int run();
+
+public:
+	uint32_t runs = 10;
+	uint32_t warmup = 2;
+	//! Number of functions of the synthetic source (0: disabled)
+	uint32_t synthetic = 2000;
+	bool nocompile = false;
+	bool norun = false;
+	bool verbose = false;
+	yuni::String filter;
+	yuni::String jsonFilename;
+	std::vector<yuni::String> filenames;
+	std::vector<Result> results;
+
+private:
+	bool accept(const AnyString& name) const;
+	void measure(Result&, const std::function<bool ()>&);
+	void benchCompileContent(const char* name, const std::string& content);
+	void benchCompileFile(const yuni::String& filename);
+	void benchRunFile(const yuni::String& filename);
+	nyprogram_t* compileFile(const yuni::String& filename);
+	void printResult(const Result&) const;
+	bool writeJSON() const;
+
+	nycompile_opts_t opts;
+	nyvm_opts_t vmopts;
+};
+
+uint64_t now() {
+	auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+Stats statistics(std::vector<uint64_t> samples) {
+	Stats stats;
+	if (samples.empty())
+		return stats;
+	std::sort(samples.begin(), samples.end());
+	auto count = samples.size();
+	stats.min = samples.front();
+	stats.max = samples.back();
+	stats.median = (count % 2 != 0)
+		? samples[count / 2]
+		: (samples[count / 2 - 1] + samples[count / 2]) / 2;
+	double sum = 0.;
+	for (auto sample: samples)
+		sum += static_cast<double>(sample);
+	stats.mean = sum / static_cast<double>(count);
+	if (count > 1) {
+		double variance = 0.;
+		for (auto sample: samples) {
+			double delta = static_cast<double>(sample) - stats.mean;
+			variance += delta * delta;
+		}
+		stats.stddev = std::sqrt(variance / static_cast<double>(count - 1));
+	}
+	return stats;
+}
+
+//! Source with a large amount of functions and classes, all instanciated from `main`
+std::string makeSyntheticSource(uint32_t count) {
+	std::string source;
+	source.reserve(count * 256);
+	char buffer[256];
+	for (uint32_t i = 0; i != count; ++i) {
+		snprintf(buffer, sizeof(buffer),
+			"class Synthetic%u {\n"
+			"\tfunc compute(x: u32): u32 {\n"
+			"\t\tvar y = x + %uu;\n"
+			"\t\tif y > 1000u then\n"
+			"\t\t\ty -= 7u;\n"
+			"\t\treturn y * 3u;\n"
+			"\t}\n"
+			"\tvar value = %uu;\n"
+			"}\n"
+			"\n"
+			"func synthetic%u(x: u32): u32 {\n"
+			"\tvar s = new Synthetic%u;\n"
+			"\treturn s.compute(x) + s.value;\n"
+			"}\n\n", i, i, i, i, i);
+		source += buffer;
+	}
+	source += "func main {\n\tvar sum = 0u;\n";
+	for (uint32_t i = 0; i != count; ++i) {
+		snprintf(buffer, sizeof(buffer), "\tsum += synthetic%u(%uu);\n", i, i);
+		source += buffer;
+	}
+	source += "\tconsole << sum << \"\\n\";\n}\n";
+	return source;
+}
+
+const char* plurals(size_t count, const char* single, const char* many) {
+	return (count <= 1) ? single : many;
+}
+
+void jsonString(std::ostream& out, const AnyString& text) {
+	out << '"';
+	for (uint32_t i = 0; i != text.size(); ++i) {
+		char c = text[i];
+		switch (c) {
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\t': out << "\\t"; break;
+			default: {
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+					out << buffer;
+				}
+				else
+					out << c;
+			}
+		}
+	}
+	out << '"';
+}
+
+std::ostream& ms(std::ostream& out, double ns) {
+	return out << std::fixed << std::setprecision(3) << std::setw(11) << (ns / 1e6);
+}
+
+App::App() {
+	memset(&opts, 0x0, sizeof(opts));
+	opts.userdata = this;
+	opts.entrypoint.c_str = "main";
+	opts.entrypoint.len = 4;
+	opts.on_report = [](void* userdata, const nyreport_t* report) {
+		// a failure would be reported by each run, only the status is kept otherwise
+		if (reinterpret_cast<App*>(userdata)->verbose)
+			nyreport_print_stdout(report);
+	};
+	nyvm_opts_init_defaults(&vmopts);
+	// the output of the programs would only disturb the measures
+	vmopts.cout.write = [](nyconsole_t*, const char*, size_t) {};
+	vmopts.cout.flush = [](nyconsole_t*) {};
+}
+
+void App::importFilenames(const std::vector<yuni::String>& list) {
+	yuni::String tmpstr;
+	yuni::ShortString16 ext;
+	for (auto& filename: list) {
+		yuni::IO::Canonicalize(tmpstr, filename);
+		switch (yuni::IO::TypeOf(tmpstr)) {
+			case yuni::IO::typeFile: {
+				filenames.emplace_back(tmpstr);
+				break;
+			}
+			case yuni::IO::typeFolder: {
+				yuni::IO::Directory::Info info(tmpstr);
+				auto end = info.recursive_file_end();
+				for (auto i = info.recursive_file_begin(); i != end; ++i) {
+					yuni::IO::ExtractExtension(ext, *i);
+					if (ext == ".ny")
+						filenames.emplace_back(i.filename());
+				}
+				break;
+			}
+			default:
+				throw std::runtime_error((std::string("impossible to find '") += tmpstr.c_str()) += '\'');
+		}
+	}
+	// always the same order, for comparing the results
+	std::sort(filenames.begin(), filenames.end());
+}
+
+bool App::accept(const AnyString& name) const {
+	return filter.empty() or name.find(filter) < name.size();
+}
+
+void App::measure(Result& result, const std::function<bool ()>& callback) {
+	result.success = true;
+	for (uint32_t i = 0; i != warmup and result.success; ++i)
+		result.success = callback();
+	result.samples.reserve(runs);
+	for (uint32_t i = 0; i != runs and result.success; ++i) {
+		auto start = now();
+		result.success = callback();
+		result.samples.push_back(now() - start);
+	}
+	result.stats = statistics(result.samples);
+	printResult(result);
+}
+
+void App::benchCompileContent(const char* name, const std::string& content) {
+	if (not accept(name))
+		return;
+	results.emplace_back();
+	auto& result = results.back();
+	result.kind = "compile";
+	result.name = name;
+	measure(result, [&]() -> bool {
+		auto* program = nyprogram_compile_from_content(&opts, content.c_str(), content.size());
+		nyprogram_free(program);
+		return program != nullptr;
+	});
+}
+
+nyprogram_t* App::compileFile(const yuni::String& filename) {
+	return nyprogram_compile_from_file(&opts, filename.c_str(), filename.size());
+}
+
+void App::benchCompileFile(const yuni::String& filename) {
+	results.emplace_back();
+	auto& result = results.back();
+	result.kind = "compile";
+	result.name = filename;
+	measure(result, [&]() -> bool {
+		auto* program = compileFile(filename);
+		nyprogram_free(program);
+		return program != nullptr;
+	});
+}
+
+void App::benchRunFile(const yuni::String& filename) {
+	results.emplace_back();
+	auto& result = results.back();
+	result.kind = "run";
+	result.name = filename;
+	auto* program = compileFile(filename);
+	if (unlikely(!program))
+		return printResult(result);
+	measure(result, [&]() -> bool {
+		return nytrue == nyvm_run_entrypoint(&vmopts, program);
+	});
+	nyprogram_free(program);
+}
+
+void App::printResult(const Result& result) const {
+	std::cout << "  " << std::left << std::setw(8) << result.kind << std::right;
+	if (unlikely(not result.success)) {
+		std::cout << "     FAILED" << std::setw(50) << ' ' << result.name << '\n';
+		return;
+	}
+	auto& stats = result.stats;
+	ms(std::cout, static_cast<double>(stats.min)) << ' ';
+	ms(std::cout, static_cast<double>(stats.median)) << ' ';
+	ms(std::cout, stats.mean) << ' ';
+	ms(std::cout, static_cast<double>(stats.max)) << ' ';
+	ms(std::cout, stats.stddev) << "  " << result.name << std::endl;
+}
+
+bool App::writeJSON() const {
+	std::ofstream out(jsonFilename.c_str(), std::ios::out | std::ios::trunc);
+	out << "{\"version\": ";
+	jsonString(out, libnanyc_version_to_cstr());
+	out << ", \"runs\": " << runs << ", \"warmup\": " << warmup << ", \"benchmarks\": [";
+	bool first = true;
+	for (auto& result: results) {
+		out << (first ? "\n" : ",\n");
+		first = false;
+		auto& stats = result.stats;
+		out << "  {\"kind\": \"" << result.kind << "\", \"name\": ";
+		jsonString(out, result.name);
+		out << ", \"success\": " << (result.success ? "true" : "false");
+		out << ", \"min_ns\": " << stats.min << ", \"median_ns\": " << stats.median;
+		out << ", \"mean_ns\": " << static_cast<uint64_t>(stats.mean) << ", \"max_ns\": " << stats.max;
+		out << ", \"stddev_ns\": " << static_cast<uint64_t>(stats.stddev) << ", \"samples_ns\": [";
+		for (size_t i = 0; i != result.samples.size(); ++i)
+			out << (i != 0 ? ", " : "") << result.samples[i];
+		out << "]}";
+	}
+	out << "\n]}\n";
+	out.close();
+	if (not out) {
+		std::cerr << "failed to write '" << jsonFilename << "'\n";
+		return false;
+	}
+	return true;
+}
+
+int App::run() {
+	std::cout << "benchmarks: " << runs << ' ' << plurals(runs, "run", "runs");
+	std::cout << ", " << warmup << " warmup " << plurals(warmup, "run", "runs") << "\n\n";
+	std::cout << "  kind         min ms   median ms     mean ms      max ms   stddev ms  benchmark\n";
+	if (not nocompile) {
+		// the whole NSL, with an empty program
+		benchCompileContent("<nsl>", "func main {}\n");
+		if (synthetic != 0) {
+			std::string name{"<synthetic:"};
+			name += std::to_string(synthetic);
+			name += '>';
+			benchCompileContent(name.c_str(), makeSyntheticSource(synthetic));
+		}
+		for (auto& filename: filenames) {
+			if (accept(filename))
+				benchCompileFile(filename);
+		}
+	}
+	if (not norun) {
+		for (auto& filename: filenames) {
+			if (accept(filename))
+				benchRunFile(filename);
+		}
+	}
+	bool success = std::all_of(results.begin(), results.end(), [](auto& result) { return result.success; });
+	if (not jsonFilename.empty())
+		success &= writeJSON();
+	std::cout << '\n';
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int printVersion() {
+	std::cout << libnanyc_version_to_cstr() << '\n';
+	return EXIT_SUCCESS;
+}
+
+void prepare(App& app, int argc, char** argv) {
+	bool version = false;
+	std::vector<yuni::String> filenames;
+	yuni::GetOpt::Parser options;
+	options.add(filenames, 'i', "input", "Input nanyc benchmarks (files or folders)");
+	options.add(app.runs, 'n', "runs", "Number of measured runs per benchmark (default: 10)");
+	options.add(app.warmup, 'w', "warmup", "Number of runs before measuring (default: 2)");
+	options.add(app.filter, 'f', "filter", "Only the benchmarks whose name contains the given text");
+	options.add(app.synthetic, ' ', "synthetic", "Number of functions of the synthetic source (default: 2000, 0: disabled)");
+	options.addFlag(app.nocompile, ' ', "no-compile", "Do not measure the compilation");
+	options.addFlag(app.norun, ' ', "no-run", "Do not measure the execution");
+	options.addParagraph("\nOutput");
+	options.add(app.jsonFilename, 'o', "json", "Write all measures in JSON to the given file");
+	options.addParagraph("\nHelp");
+	options.addFlag(app.verbose, 'v', "verbose", "More stuff on the screen");
+	options.addFlag(version, ' ', "version", "Print the version");
+	options.remainingArguments(filenames);
+	if (not options(argc, argv)) {
+		if (options.errors())
+			throw std::runtime_error("Abort due to error");
+		throw EXIT_SUCCESS;
+	}
+	if (unlikely(version))
+		throw printVersion();
+	if (unlikely(app.runs == 0))
+		throw "invalid null number of runs (-n,--runs)";
+	app.importFilenames(filenames);
+}
+
+} // namespace
+} // namespace bench
+} // namespace ny
+
+int main(int argc, char** argv) {
+	try {
+		ny::bench::App app;
+		ny::bench::prepare(app, argc, argv);
+		return app.run();
+	}
+	catch (const char* e) {
+		std::cerr << "error: " << e << '\n';
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << '\n';
+	}
+	catch (int e) {
+		return e;
+	}
+	return EXIT_FAILURE;
+}
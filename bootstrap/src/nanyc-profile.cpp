@@ -0,0 +1,300 @@
+#include "nanyc-profile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+//! Count the allocations (set once, before any compilation starts its threads)
+bool countAllocations = false;
+
+//! Number of allocations performed by the current thread
+thread_local uint64_t allocationCount = 0;
+
+struct Measure final {
+	nycompile_phase_t phase;
+	std::string name;
+	uint32_t atomid;
+	uint32_t count;
+	uint64_t wall;
+	uint64_t cpu;
+	uint64_t self;
+	uint64_t allocations;
+};
+
+struct {
+	ny::profile::Format format = ny::profile::Format::table;
+	std::vector<Measure> measures;
+}
+compilation;
+
+struct Function final {
+	std::string name;
+	uint64_t calls;
+	uint64_t inclusive;
+	uint64_t exclusive;
+	//! The most frequent opcodes
+	std::vector<std::pair<std::string, uint64_t>> opcodes;
+};
+
+struct {
+	bool enabled = false;
+	std::string foldedFilename;
+	std::vector<Function> functions;
+	std::vector<std::pair<std::string, uint64_t>> stacks;
+}
+execution;
+
+const char* phaseName(nycompile_phase_t phase) {
+	switch (phase) {
+		case nycompile_phase_parse: return "parse";
+		case nycompile_phase_normalize: return "normalize";
+		case nycompile_phase_ast2ir: return "ast2ir";
+		case nycompile_phase_cache: return "cache";
+		case nycompile_phase_attach: return "attach";
+		case nycompile_phase_typedefs: return "typedefs";
+		case nycompile_phase_instanciate: return "instanciate";
+		case nycompile_phase_link: return "link";
+		case nycompile_phase_total: return "total";
+	}
+	return "unknown";
+}
+
+void onProfile(void*, const nycompile_profile_t* profile) {
+	Measure measure;
+	measure.phase = profile->phase;
+	measure.name.assign(profile->name.c_str, profile->name.len);
+	measure.atomid = profile->atomid;
+	measure.count = profile->count;
+	measure.wall = profile->wall_ns;
+	measure.cpu = profile->cpu_ns;
+	measure.self = profile->self_ns;
+	measure.allocations = profile->allocations;
+	compilation.measures.emplace_back(std::move(measure));
+}
+
+uint64_t onAllocationCount(void*) {
+	return allocationCount;
+}
+
+void onProfileFunc(void*, const nyvm_profile_func_t* profile) {
+	constexpr uint32_t limit = 3; // arbitrary
+	Function func;
+	func.name.assign(profile->name.c_str, profile->name.len);
+	func.calls = profile->calls;
+	func.inclusive = profile->inclusive_ns;
+	func.exclusive = profile->exclusive_ns;
+	for (uint32_t i = 0; i != std::min(limit, profile->opcode_count); ++i)
+		func.opcodes.emplace_back(profile->opcodes[i].name, profile->opcodes[i].count);
+	execution.functions.emplace_back(std::move(func));
+}
+
+void onProfileStack(void*, const nyvm_profile_stack_t* profile) {
+	std::string folded{profile->folded.c_str, profile->folded.len};
+	execution.stacks.emplace_back(std::move(folded), profile->exclusive_ns);
+}
+
+std::ostream& ms(std::ostream& out, uint64_t ns) {
+	return out << std::fixed << std::setprecision(3) << std::setw(12) << (static_cast<double>(ns) / 1e6);
+}
+
+void jsonString(std::ostream& out, const std::string& text) {
+	out << '"';
+	for (char c: text) {
+		switch (c) {
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\t': out << "\\t"; break;
+			default: {
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+					out << buffer;
+				}
+				else
+					out << c;
+			}
+		}
+	}
+	out << '"';
+}
+
+void printJSON(std::ostream& out) {
+	out << "{\"compile\": [";
+	bool first = true;
+	for (auto& m: compilation.measures) {
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << "  {\"phase\": \"" << phaseName(m.phase) << "\", \"name\": ";
+		jsonString(out, m.name);
+		out << ", \"atomid\": " << m.atomid << ", \"count\": " << m.count;
+		out << ", \"wall_ns\": " << m.wall << ", \"cpu_ns\": " << m.cpu << ", \"self_ns\": " << m.self;
+		out << ", \"allocations\": " << m.allocations << '}';
+	}
+	out << "\n]}\n";
+}
+
+void printTable(std::ostream& out) {
+	constexpr uint32_t phaseCount = static_cast<uint32_t>(nycompile_phase_total) + 1;
+	Measure phases[phaseCount];
+	for (uint32_t i = 0; i != phaseCount; ++i)
+		phases[i] = Measure{static_cast<nycompile_phase_t>(i), std::string{}, 0, 0, 0, 0, 0, 0};
+	std::unordered_map<std::string, Measure> sources;
+	std::vector<const Measure*> atoms;
+	for (auto& m: compilation.measures) {
+		auto& phase = phases[static_cast<uint32_t>(m.phase)];
+		phase.count += m.count;
+		phase.cpu += m.cpu;
+		phase.allocations += m.allocations;
+		// the nested instanciations would be counted several times
+		phase.wall += (m.phase == nycompile_phase_instanciate) ? m.self : m.wall;
+		if (m.phase == nycompile_phase_instanciate) {
+			atoms.push_back(&m);
+			continue;
+		}
+		if (m.name.empty())
+			continue;
+		auto& source = sources[m.name];
+		source.name = m.name;
+		source.wall += m.wall;
+		source.cpu += m.cpu;
+		source.allocations += m.allocations;
+	}
+	out << "\ncompiler phases      count      wall ms       cpu ms   allocations\n";
+	for (auto& phase: phases) {
+		if (phase.count == 0)
+			continue;
+		out << "  " << std::left << std::setw(14) << phaseName(phase.phase) << std::right;
+		out << std::setw(9) << phase.count << ' ';
+		ms(out, phase.wall) << ' ';
+		ms(out, phase.cpu) << ' ' << std::setw(13) << phase.allocations << '\n';
+	}
+	std::vector<const Measure*> list;
+	for (auto& it: sources)
+		list.push_back(&it.second);
+	std::sort(list.begin(), list.end(), [](auto* a, auto* b) { return a->wall > b->wall; });
+	constexpr size_t limit = 20; // arbitrary
+	out << "\nsource files (front-end and attach, by time)\n";
+	out << "       wall ms       cpu ms   allocations  filename\n";
+	for (size_t i = 0; i != std::min(limit, list.size()); ++i) {
+		auto& source = *list[i];
+		out << "  ";
+		ms(out, source.wall) << ' ';
+		ms(out, source.cpu) << ' ' << std::setw(13) << source.allocations << "  " << source.name << '\n';
+	}
+	std::sort(atoms.begin(), atoms.end(), [](auto* a, auto* b) { return a->self > b->self; });
+	out << "\ninstanciations (by self time)\n";
+	out << "  instances      self ms      wall ms   allocations  atom\n";
+	for (size_t i = 0; i != std::min(limit, atoms.size()); ++i) {
+		auto& atom = *atoms[i];
+		out << "  " << std::setw(9) << atom.count << ' ';
+		ms(out, atom.self) << ' ';
+		ms(out, atom.wall) << ' ' << std::setw(13) << atom.allocations << "  ";
+		out << (atom.name.empty() ? std::string{"<unknown>"} : atom.name) << '\n';
+	}
+	out << '\n';
+}
+
+} // namespace
+
+// The replacement is global to the driver (libnanyc included), but only costs
+// a branch when the compiler is not profiled
+void* operator new(std::size_t size) {
+	if (countAllocations)
+		++allocationCount;
+	void* p = malloc(size != 0 ? size : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	free(p);
+}
+
+namespace ny {
+namespace profile {
+
+bool parseFormat(Format& format, const char* const value) {
+	if (value[0] == '\0' or !strcmp(value, "table"))
+		format = Format::table;
+	else if (!strcmp(value, "json"))
+		format = Format::json;
+	else
+		return false;
+	return true;
+}
+
+void compile(nycompile_opts_t& opts, Format format) {
+	compilation.format = format;
+	countAllocations = true;
+	opts.on_profile = &onProfile;
+	opts.allocation_count = &onAllocationCount;
+}
+
+void printCompile() {
+	if (compilation.measures.empty())
+		return;
+	if (compilation.format == Format::json)
+		printJSON(std::cerr);
+	else
+		printTable(std::cerr);
+}
+
+void run(nyvm_opts_t& opts, const char* const foldedFilename) {
+	execution.enabled = true;
+	execution.foldedFilename = foldedFilename;
+	opts.on_profile_func = &onProfileFunc;
+	opts.on_profile_stack = &onProfileStack;
+}
+
+bool printRun() {
+	if (not execution.enabled)
+		return true;
+	auto& out = std::cerr;
+	auto& functions = execution.functions;
+	std::sort(functions.begin(), functions.end(), [](auto& a, auto& b) { return a.exclusive > b.exclusive; });
+	constexpr size_t limit = 30; // arbitrary
+	out << "\nfunctions (by self time)\n";
+	out << "        calls      self ms     total ms  function  [top opcodes]\n";
+	for (size_t i = 0; i != std::min(limit, functions.size()); ++i) {
+		auto& func = functions[i];
+		out << "  " << std::setw(11) << func.calls << ' ';
+		ms(out, func.exclusive) << ' ';
+		ms(out, func.inclusive) << "  " << func.name << "  [";
+		for (size_t o = 0; o != func.opcodes.size(); ++o)
+			out << (o != 0 ? ", " : "") << func.opcodes[o].first << ": " << func.opcodes[o].second;
+		out << "]\n";
+	}
+	out << '\n';
+	if (execution.foldedFilename.empty())
+		return true;
+	// folded stacks, one per line, with their self time in nanoseconds (flamegraph.pl, speedscope...)
+	std::ofstream file(execution.foldedFilename, std::ios::out | std::ios::trunc);
+	for (auto& stack: execution.stacks) {
+		if (stack.second != 0)
+			file << stack.first << ' ' << stack.second << '\n';
+	}
+	file.close();
+	if (not file) {
+		std::cerr << "failed to write '" << execution.foldedFilename << "'\n";
+		return false;
+	}
+	return true;
+}
+
+} // namespace profile
+} // namespace ny
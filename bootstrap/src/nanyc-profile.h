@@ -0,0 +1,29 @@
+#pragma once
+#include <nanyc/program.h>
+#include <nanyc/vm.h>
+
+namespace ny {
+namespace profile {
+
+enum class Format {
+	table,
+	json,
+};
+
+//! Get the output format from a command line value (`table` or `json`, empty for the default)
+bool parseFormat(Format& format, const char* const value);
+
+//! Record the measures of the compiler (see `nycompile_opts_t.on_profile`)
+void compile(nycompile_opts_t& opts, Format format);
+
+//! Print the measures of the compiler to std::cerr
+void printCompile();
+
+//! Record the measures of the VM (see `nyvm_opts_t.on_profile_func`)
+void run(nyvm_opts_t& opts, const char* const foldedFilename);
+
+//! Print the summary of the VM to std::cerr, and write the folded stacks if requested
+bool printRun();
+
+} // namespace profile
+} // namespace ny
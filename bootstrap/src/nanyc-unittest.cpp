@@ -13,10 +13,18 @@
 #include <yuni/yuni.h>
 #include <iostream>
 #include <vector>
+#include <deque>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include "libnanyc.h"
+#include "../libnanyc/libnanyc-config.h"
 #include "../libnanyc/libnanyc-traces.h"
 
 
@@ -47,6 +55,9 @@ struct App final {
 	void fetch();
 	void run(const Entry&);
 	int run();
+	nyprogram_t* compileAll();
+	void runInProcess(const nyprogram_t*);
+	void runInSubprocesses();
 	bool statstics(int64_t duration);
 	void setcolor(yuni::System::Console::Color) const;
 	void resetcolor() const;
@@ -63,13 +74,19 @@ struct App final {
 	bool colors = true;
 	bool verbose = false;
 	bool withnsl = false;
+	bool isolated = false;
 	uint32_t loops = 1;
 	bool shuffle = false;
 	uint32_t timeout_s = 30;
+	//! Optimization level of the instanciated code (0: none, 1: basic, 2: full)
+	uint32_t optimize = 2;
 	std::vector<Entry> unittests;
 	std::vector<yuni::String> filenames;
+	yuni::String cachepath;
 	std::vector<Result> results;
 	uint32_t jobs = 0;
+	//! Number of threads still running an unittest after a timeout (in-process mode)
+	uint32_t abandoned = 0;
 	yuni::Mutex mutex;
 
 	Entry execinfo;
@@ -79,16 +96,101 @@ private:
 	void startEntry(const Entry&);
 	void endEntry(const Entry&, bool, int64_t);
 	bool execute(const Entry& entry);
+	bool executeInProcess(const nyprogram_t*, const Entry& entry);
 	bool writeProgress();
+	std::vector<Entry> schedule();
 
 	yuni::String runningMsg;
 	const Entry* latestRunningUnittest = nullptr;
 	nysource_opts_t srcoptsEmpty;
 };
 
+//! Host intrinsic for the unittests (nsl.selftest/core/host-intrinsic.ny)
+void selftestMix(nyvmthread_t*, const nyvalue_t* params, nyvalue_t* ret) {
+	ret->u64 = params[0].u64 * 31u + params[1].u64;
+}
+
+const nytype_t selftestMixParams[] = {nyt_u64, nyt_u32};
+
+nyintrinsic_t selftestIntrinsics[] = {
+	{{"nanyc.selftest.mix", 18}, &selftestMix, nyt_u64, selftestMixParams, 2},
+};
+
+/*!
+** \brief Check that invalid host intrinsics are rejected by the compiler
+**
+** The intrinsics are checked before reading any source, each compilation
+** must fail immediately.
+*/
+void checkInvalidHostIntrinsics() {
+	nytype_t tooManyParams[config::maxPushedParameters];
+	for (auto& type: tooManyParams)
+		type = nyt_u64;
+	const nytype_t anyParam[] = {nyt_any};
+	const nytype_t voidParam[] = {nyt_void};
+	auto& valid = selftestIntrinsics[0];
+	auto invalid = [&](nytype_t rettype, const nytype_t* params, uint32_t count) -> nyintrinsic_t {
+		return nyintrinsic_t{valid.name, valid.callback, rettype, params, count};
+	};
+	struct { const char* reason; std::vector<nyintrinsic_t> list; } checks[] = {
+		{"duplicate name", {valid, valid}},
+		{"param 'any'", {invalid(nyt_u64, anyParam, 1)}},
+		{"param 'void'", {invalid(nyt_u64, voidParam, 1)}},
+		{"return type 'any'", {invalid(nyt_any, nullptr, 0)}},
+		{"too many params", {invalid(nyt_u64, tooManyParams, config::maxPushedParameters)}},
+		{"null params", {invalid(nyt_u64, nullptr, 1)}},
+		{"null callback", {nyintrinsic_t{valid.name, nullptr, nyt_void, nullptr, 0}}},
+	};
+	nycompile_opts_t opts;
+	memset(&opts, 0x0, sizeof(opts));
+	opts.on_report = [](void*, const nyreport_t*) {};
+	for (auto& check: checks) {
+		opts.intrinsics.items = check.list.data();
+		opts.intrinsics.count = static_cast<uint32_t>(check.list.size());
+		auto* program = nyprogram_compile_from_content(&opts, "func main {}", 12);
+		if (unlikely(program != nullptr)) {
+			nyprogram_free(program);
+			throw std::runtime_error(std::string{"host intrinsics: not rejected: "} + check.reason);
+		}
+	}
+}
+
+/*!
+** \brief Check that an unbounded recursion is reported as a call stack overflow
+**
+** The VM does not use the native stack for func calls, the program must fail
+** with a proper error instead of crashing the process.
+*/
+void checkCallStackOverflow() {
+	constexpr const char content[] = "func recurse { recurse(); }\nfunc main { recurse(); }";
+	nycompile_opts_t opts;
+	memset(&opts, 0x0, sizeof(opts));
+	opts.on_report = [](void*, const nyreport_t*) {};
+	auto* program = nyprogram_compile_from_content(&opts, content, sizeof(content) - 1);
+	if (unlikely(program == nullptr))
+		throw std::runtime_error("call stack overflow: failed to compile");
+	std::string errors;
+	nyvm_opts_t vmopts;
+	nyvm_opts_init_defaults(&vmopts);
+	vmopts.max_call_depth = 64;
+	vmopts.cerr.userdata = &errors;
+	vmopts.cerr.write = [](nyconsole_t* console, const char* text, size_t len) {
+		reinterpret_cast<std::string*>(console->userdata)->append(text, len);
+	};
+	vmopts.cerr.flush = [](nyconsole_t*) {};
+	vmopts.cerr.set_color = [](nyconsole_t*, nycolor_t) {};
+	vmopts.cerr.set_bkcolor = [](nyconsole_t*, nycolor_t) {};
+	bool success = (nytrue == nyvm_run_entrypoint(&vmopts, program));
+	nyprogram_free(program);
+	if (unlikely(success or errors.find("call stack overflow") == std::string::npos))
+		throw std::runtime_error("call stack overflow: not reported");
+}
+
 App::App() {
 	memset(&opts, 0x0, sizeof(opts));
 	opts.userdata = this;
+	opts.intrinsics.items = selftestIntrinsics;
+	opts.intrinsics.count = static_cast<uint32_t>(sizeof(selftestIntrinsics) / sizeof(selftestIntrinsics[0]));
 	memset(&srcoptsEmpty, 0x0, sizeof(srcoptsEmpty));
 	srcoptsEmpty.content.c_str = " ";
 	srcoptsEmpty.content.len = 1;
@@ -318,6 +420,14 @@ void App::run(const Entry& entry) {
 	program.argumentAdd(entry.name);
 	if (withnsl)
 		program.argumentAdd("--nsl");
+	if (not cachepath.empty()) {
+		program.argumentAdd("--cache");
+		program.argumentAdd(cachepath);
+	}
+	yuni::ShortString16 level;
+	level << optimize;
+	program.argumentAdd("--optimize");
+	program.argumentAdd(level);
 	for (auto& filename: filenames)
 		program.argumentAdd(filename);
 	auto start = now();
@@ -334,37 +444,180 @@ void shuffleDeck(std::vector<Entry>& unittests) {
 	std::shuffle(unittests.begin(), unittests.end(), std::default_random_engine(useed));
 }
 
+std::vector<Entry> App::schedule() {
+	std::vector<Entry> list;
+	list.reserve(loops * unittests.size());
+	for (uint32_t l = 0; l != loops; ++l) {
+		if (unlikely(shuffle))
+			shuffleDeck(unittests);
+		list.insert(list.end(), unittests.begin(), unittests.end());
+	}
+	return list;
+}
+
+void App::runInSubprocesses() {
+	auto list = schedule();
+	yuni::Job::QueueService queueservice;
+	queueservice.maximumThreadCount(jobs);
+	queueservice.minimumThreadCount(jobs);
+	for (auto& entry: list)
+		yuni::async(queueservice, [&,this] { run(entry); });
+	auto progress = yuni::every(150 /*ms*/, [this] { return writeProgress(); });
+	queueservice.start();
+	queueservice.wait(yuni::qseIdle);
+}
+
+nyprogram_t* App::compileAll() {
+	std::cout << "compiling all tests...\n" << std::flush;
+	std::vector<yuni::String> names;
+	std::vector<nyanystr_t> entrypoints;
+	names.reserve(unittests.size());
+	for (auto& entry: unittests) {
+		names.emplace_back();
+		names.back() << "^unittest^module:" << entry.name;
+	}
+	entrypoints.resize(names.size());
+	for (size_t i = 0; i != names.size(); ++i) {
+		entrypoints[i].c_str = names[i].c_str();
+		entrypoints[i].len = names[i].size();
+	}
+	opts.entrypoint.len = 0;
+	opts.entrypoints.items = entrypoints.data();
+	opts.entrypoints.count = static_cast<uint32_t>(entrypoints.size());
+	// errors will be reported by each unittest if the isolated mode is required
+	opts.on_report = [](void*, const nyreport_t*) {};
+	if (opts.sources.count == 0) {
+		opts.sources.count = 1;
+		opts.sources.items = &srcoptsEmpty;
+	}
+	auto* program = nyprogram_compile(&opts);
+	if (opts.sources.items == &srcoptsEmpty) {
+		opts.sources.count = 0;
+		opts.sources.items = nullptr;
+	}
+	opts.entrypoints.items = nullptr;
+	opts.entrypoints.count = 0;
+	opts.on_report = nullptr;
+	if (unlikely(!program))
+		std::cout << "failed to compile all tests at once, falling back to isolated mode\n";
+	return program;
+}
+
+bool App::executeInProcess(const nyprogram_t* program, const Entry& entry) {
+	yuni::ShortString128 name;
+	name << "^unittest^module:" << entry.name;
+	nyvm_opts_t vmopts;
+	nyvm_opts_init_defaults(&vmopts);
+	// the unittests are already run concurrently, a pool per unittest would be wasteful
+	vmopts.async_threads = 1;
+	return nytrue == nyvm_run_entrypoint_by_name(&vmopts, program, name.c_str(), name.size());
+}
+
+void App::runInProcess(const nyprogram_t* program) {
+	constexpr uint32_t idle = static_cast<uint32_t>(-1);
+	struct Worker final {
+		std::thread thread;
+		//! Index of the running unittest, `idle` otherwise
+		std::atomic<uint32_t> current{idle};
+		std::atomic<int64_t> since{0};
+		bool abandoned = false;
+	};
+	struct State final {
+		std::vector<Entry> list;
+		//! Index of the next unittest to run (each worker picks the next available one)
+		std::atomic<uint32_t> next{0};
+		std::deque<Worker> workers;
+	};
+	// the state must outlive any abandoned thread
+	auto state = std::make_unique<State>();
+	state->list = schedule();
+	uint32_t total = static_cast<uint32_t>(state->list.size());
+	auto spawn = [this, program, total](State& state) {
+		state.workers.emplace_back();
+		auto& worker = state.workers.back();
+		worker.thread = std::thread([this, program, total, &state, &worker]() {
+			for (uint32_t i; (i = state.next++) < total; ) {
+				auto& entry = state.list[i];
+				startEntry(entry);
+				auto start = now();
+				worker.since = start;
+				worker.current = i;
+				bool success = executeInProcess(program, entry);
+				// the unittest may already have been reported as timed out
+				uint32_t expected = i;
+				if (not worker.current.compare_exchange_strong(expected, idle))
+					return;
+				endEntry(entry, success, now() - start);
+			}
+		});
+	};
+	for (uint32_t j = 0; j != std::min(jobs, total); ++j)
+		spawn(*state);
+	auto timeout = static_cast<int64_t>(timeout_s) * 1000;
+	while (true) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(150));
+		{
+			yuni::MutexLocker locker(mutex);
+			if (results.size() == total)
+				break;
+		}
+		// `spawn()` invalidates the iterators of the deque (not the references)
+		size_t count = state->workers.size();
+		for (size_t w = 0; w != count; ++w) {
+			auto& worker = state->workers[w];
+			uint32_t i = worker.current;
+			if (i == idle or worker.abandoned)
+				continue;
+			auto duration = now() - worker.since;
+			if (duration > timeout and worker.current.compare_exchange_strong(i, idle)) {
+				// a running unittest can not be interrupted, the thread is abandoned
+				worker.abandoned = true;
+				++abandoned;
+				endEntry(state->list[i], false, duration);
+				spawn(*state);
+			}
+		}
+		if (interactive)
+			writeProgress();
+	}
+	for (auto& worker: state->workers) {
+		if (not worker.abandoned)
+			worker.thread.join();
+		else
+			worker.thread.detach();
+	}
+	if (abandoned != 0)
+		state.release(); // still used, until exit
+}
+
 int App::run() {
 	bool success;
 	if (not inExecutorMode()) {
+		auto* program = (not isolated and not unittests.empty()) ? compileAll() : nullptr;
 		if (verbose or not interactive) {
 			std::cout << '\n';
 			setcolor(yuni::System::Console::bold);
-			std::cout << "running all tests (" << jobs << " concurrent " << plurals(jobs, "job", "jobs") << ")...";
+			std::cout << "running all tests (-O" << optimize << ", " << jobs << " concurrent " << plurals(jobs, "job", "jobs");
+			std::cout << (program ? ")..." : ", isolated)...");
 			resetcolor();
 			std::cout << '\n';
 		}
 		stats.total = static_cast<uint32_t>(loops * unittests.size());
 		results.reserve(stats.total);
 		std::cout << '\n';
-		yuni::Job::QueueService queueservice;
-		queueservice.maximumThreadCount(jobs);
-		queueservice.minimumThreadCount(jobs);
-		for (uint32_t l = 0; l != loops; ++l) {
-			if (unlikely(shuffle))
-				shuffleDeck(unittests);
-			for (auto& entry: unittests)
-				yuni::async(queueservice, [&,this] { run(entry); });
-		}
 		auto start = now();
-		auto duration = start;
-		{
-			auto progress = yuni::every(150 /*ms*/, [this] { return writeProgress(); });
-			queueservice.start();
-			queueservice.wait(yuni::qseIdle);
-			duration = now() - start;
-		}
+		if (program)
+			runInProcess(program);
+		else
+			runInSubprocesses();
+		auto duration = now() - start;
 		success = statstics(duration);
+		if (unlikely(abandoned != 0)) {
+			// some unittests are still running, the program can not be released
+			std::cout << std::flush;
+			std::_Exit(EXIT_FAILURE);
+		}
+		nyprogram_free(program);
 	}
 	else {
 		success = execute(execinfo);
@@ -399,10 +652,13 @@ void prepare(App& app, int argc, char** argv) {
 	options.addFlag(app.withnsl, ' ', "nsl", "Import NSL unittests");
 	options.add(app.timeout_s, 't', "timeout", "Timeout for executing an unittest (seconds)");
 	options.add(app.jobs, 'j', "jobs", "Number of concurrent jobs (default: auto)");
+	options.add(app.cachepath, ' ', "cache", "Directory for caching the compiled source files");
+	options.add(app.optimize, 'O', "optimize", "Optimization level: 0 (none), 1 (basic), 2 (full, default)");
 	options.add(app.execinfo.module, ' ', "executor-module", "Executor mode, module name (internal use)", false);
 	options.add(app.execinfo.name, ' ', "executor-name", "Executor mode, unittest (internal use)", false);
 	options.add(app.loops, 'n', "loops", "Number of loops (default: 1)");
 	options.addFlag(app.shuffle, 's', "shuffle", "Randomly rearrange the unittests");
+	options.addFlag(app.isolated, ' ', "isolated", "Run each unittest in its own process (crash isolation)");
 	options.addParagraph("\nDisplay");
 	options.addFlag(nocolors, ' ', "no-colors", "Disable color output");
 	options.addFlag(nointeractive, ' ', "no-progress", "Disable progression reporting");
@@ -424,6 +680,16 @@ void prepare(App& app, int argc, char** argv) {
 		printBugreport();
 	app.importFilenames(filenames);
 	app.opts.with_nsl_unittests = app.withnsl ? nytrue : nyfalse;
+	switch (app.optimize) {
+		case 0: app.opts.optimize = nyoptimize_none; break;
+		case 1: app.opts.optimize = nyoptimize_basic; break;
+		case 2: app.opts.optimize = nyoptimize_full; break;
+		default: throw "invalid optimization level (-O,--optimize)";
+	}
+	app.opts.cache_path.c_str = app.cachepath.c_str();
+	app.opts.cache_path.len = app.cachepath.size();
+	if (app.inExecutorMode())
+		app.opts.jobs = 1; // the unittests are already run concurrently
 	if (not app.inExecutorMode()) {
 		if (ny::config::traces::hasSome())
 			throw std::runtime_error("debug traces in output programs will make all tests fail");
@@ -437,6 +703,8 @@ void prepare(App& app, int argc, char** argv) {
 			and (istty or yuni::System::Environment::ReadAsBool("CLICOLOR_FORCE"));
 		app.argv0 = argv[0];
 		app.jobs = numberOfJobs(app.jobs);
+		checkInvalidHostIntrinsics();
+		checkCallStackOverflow();
 		app.fetch();
 	}
 }
@@ -17,7 +17,17 @@ int usage(const char* const argv0) {
 	std::cout << "Options:\n";
 	std::cout << "  --bugreport       Display some useful information to report a bug\n";
 	std::cout << "                    (https://github.com/nany-lang/nany/issues/new)\n";
+	std::cout << "  --cache=DIR       Cache the compiled source files (NSL, collections...) into DIR\n";
 	std::cout << "  --help, -h        Display this information\n";
+	std::cout << "  --max-call-depth=N\n";
+	std::cout << "                    Maximum depth of nested func calls at runtime\n";
+	std::cout << "  --memcheck=LEVEL  Memory checks at runtime: none, fast (default), full\n";
+	std::cout << "  -O0, -O1, -O2     Optimization level: none, basic, full (default)\n";
+	std::cout << "  --profile[=FILE]  Print the time spent in each function at runtime, and write\n";
+	std::cout << "                    the call stacks into FILE (folded format, for flamegraphs)\n";
+	std::cout << "  --profile-compile[=FORMAT]\n";
+	std::cout << "                    Print the time spent in each phase of the compiler, per source\n";
+	std::cout << "                    file and per instanciated atom: table (default), json\n";
 	std::cout << "  --version, -v     Print the version\n\n";
 	return EXIT_SUCCESS;
 }
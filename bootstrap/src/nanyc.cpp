@@ -1,5 +1,7 @@
 #include "nanyc-utils.h"
+#include "nanyc-profile.h"
 #include <nanyc/nanyc.h>
+#include <cstdlib>
 #include <cstring>
 
 namespace {
@@ -22,6 +24,30 @@ int longOptions(const char* const name, const char* const argv0) {
 	return ny::print::unknownOption(argv0, name);
 }
 
+bool memcheckOption(nyvm_opts_t& opts, const char* const value) {
+	if (!strcmp(value, "none"))
+		opts.memcheck = nyvm_memcheck_none;
+	else if (!strcmp(value, "fast"))
+		opts.memcheck = nyvm_memcheck_fast;
+	else if (!strcmp(value, "full"))
+		opts.memcheck = nyvm_memcheck_full;
+	else
+		return false;
+	return true;
+}
+
+bool optimizeOption(nycompile_opts_t& opts, const char* const value) {
+	if (!strcmp(value, "0"))
+		opts.optimize = nyoptimize_none;
+	else if (!strcmp(value, "1"))
+		opts.optimize = nyoptimize_basic;
+	else if (!strcmp(value, "2") or value[0] == '\0')
+		opts.optimize = nyoptimize_full;
+	else
+		return false;
+	return true;
+}
+
 void initializeCompileOptions(nycompile_opts_t& opts) {
 	memset(&opts, 0x0, sizeof(nycompile_opts_t));
 	opts.entrypoint.c_str = "main";
@@ -41,12 +67,41 @@ int main(int argc, const char** argv) {
 	for (int i = 1; i < argc; ++i) {
 		const char* const carg = argv[i];
 		if (carg[0] == '-') {
+			if (carg[1] == 'O') {
+				if (!optimizeOption(copts, carg + 2))
+					return ny::print::unknownOption(argv[0], carg);
+				continue;
+			}
 			if (carg[1] != '-')
 				return shortOption(carg, argv[0]);
 			if (carg[2] != '\0') { // to handle '--' option
 				if (!strcmp(carg, "--verbose")) {
 					copts.verbose = nytrue;
 				}
+				else if (!strncmp(carg, "--cache=", 8)) {
+					copts.cache_path.c_str = carg + 8;
+					copts.cache_path.len = strlen(carg + 8);
+				}
+				else if (!strncmp(carg, "--memcheck=", 11)) {
+					if (!memcheckOption(vmopts, carg + 11))
+						return ny::print::unknownOption(argv[0], carg);
+				}
+				else if (!strcmp(carg, "--profile-compile") or !strncmp(carg, "--profile-compile=", 18)) {
+					ny::profile::Format format;
+					if (!ny::profile::parseFormat(format, carg[17] == '=' ? carg + 18 : carg + 17))
+						return ny::print::unknownOption(argv[0], carg);
+					ny::profile::compile(copts, format);
+				}
+				else if (!strcmp(carg, "--profile") or !strncmp(carg, "--profile=", 10)) {
+					ny::profile::run(vmopts, carg[9] == '=' ? carg + 10 : "");
+				}
+				else if (!strncmp(carg, "--max-call-depth=", 17)) {
+					char* end = nullptr;
+					unsigned long depth = strtoul(carg + 17, &end, 10);
+					if (end == carg + 17 or *end != '\0' or depth == 0 or depth > 0xFFFFFFFFul)
+						return ny::print::unknownOption(argv[0], carg);
+					vmopts.max_call_depth = static_cast<uint32_t>(depth);
+				}
 				else
 					return longOptions(carg, argv[0]);
 			}
@@ -72,6 +127,9 @@ int main(int argc, const char** argv) {
 		uint32_t pargc = (nargc > 0) ? static_cast<uint32_t>(nargc) : 0;
 		const char** pargv = (!pargc ? nullptr : (++nargv));
 		exitstatus = nyeval(&vmopts, &copts, nargv0, strlen(nargv0), pargc, pargv);
+		ny::profile::printCompile();
+		if (!ny::profile::printRun())
+			exitstatus = EXIT_FAILURE;
 	}
 	return exitstatus;
 }